@@ -30,17 +30,16 @@ public:
     }
 };
 
-template<typename T>
-class Obfuscated {
+// Секрет, который открыт только внутри области видимости
+class TokenStore {
 private:
-    T m_value;
+    _feel_me_happy_::Secret<std::array<char, 20>> m_token = _feel_me_happy_::makeSecret("my_secret_token_xyz");
     
 public:
-    Obfuscated(T value) : m_value(FEEL(value)) {}
-    
-    T get() const { return m_value; }
-    
-    operator T() const { return get(); }
+    void printToken() const {
+        auto token = m_token.reveal();
+        std::cout << "Token: " << token->data() << std::endl;
+    }
 };
 
 int main() {
@@ -52,8 +51,8 @@ int main() {
     APIClient client;
     client.makeRequest(0);
     
-    Obfuscated<std::string> secretToken("my_secret_token_xyz");
-    std::cout << "Token: " << secretToken.get() << std::endl;
+    TokenStore tokens;
+    tokens.printToken();
     
     const char* sql = FEEL("SELECT * FROM users WHERE active = 1");
     std::cout << "SQL: " << sql << std::endl;
@@ -22,15 +22,22 @@ FeelMeHappy.h - Универсальный обфускатор с одним м
 #include <algorithm>
 #include <functional>
 #include <string>
+#include <string_view>
 #include <mutex>
 #include <condition_variable>
 #include <array>
+#include <limits>
 #include <unordered_map>
 #include <sstream>
 #include <iomanip>
 #include <codecvt>
 #include <locale>
-#include <regex>
+#if __cplusplus >= 202002L && defined(__has_include)
+    #if __has_include(<span>)
+        #include <span>
+        #define FEELMEHAPPY_SPAN
+    #endif
+#endif
 
 // Определение платформы
 #if defined(_WIN32) || defined(_WIN64)
@@ -65,6 +72,26 @@ FeelMeHappy.h - Универсальный обфускатор с одним м
     #define FEELMEHAPPY_ARM
 #endif
 
+// Доступные наборы SIMD-инструкций (ядра выбираются во время выполнения)
+#if defined(FEELMEHAPPY_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define FEELMEHAPPY_SSE2
+    #define FEELMEHAPPY_AVX2
+    #define FEELMEHAPPY_AVX512
+    #include <immintrin.h>
+#elif defined(FEELMEHAPPY_ARM64)
+    #define FEELMEHAPPY_NEON
+    #include <arm_neon.h>
+#endif
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+    #define FEELMEHAPPY_TARGET_AVX2
+    #define FEELMEHAPPY_TARGET_AVX512
+#else
+    #define FEELMEHAPPY_TARGET_AVX2 __attribute__((target("avx2")))
+    #define FEELMEHAPPY_TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+#endif
+
 #ifdef _MSC_VER
     #define FEELMEHAPPY_FORCEINLINE __forceinline
     #define FEELMEHAPPY_NOINLINE __declspec(noinline)
@@ -73,14 +100,116 @@ FeelMeHappy.h - Универсальный обфускатор с одним м
     #define FEELMEHAPPY_NOINLINE __attribute__((noinline))
 #endif
 
+// Побитовое приведение на этапе компиляции: с ним скалярный путь для
+// float/double тоже constexpr (GCC 11+, Clang 9+, MSVC 16.6+)
+#if defined(__has_builtin)
+    #if __has_builtin(__builtin_bit_cast)
+        #define FEELMEHAPPY_BIT_CAST_CONSTEXPR constexpr
+    #endif
+#endif
+#if !defined(FEELMEHAPPY_BIT_CAST_CONSTEXPR) && defined(_MSC_VER) && _MSC_VER >= 1926
+    #define FEELMEHAPPY_BIT_CAST_CONSTEXPR constexpr
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define FEELMEHAPPY_PREFETCH(address) __builtin_prefetch(address)
+#elif defined(FEELMEHAPPY_SSE2)
+    #define FEELMEHAPPY_PREFETCH(address) _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0)
+#else
+    #define FEELMEHAPPY_PREFETCH(address) ((void)(address))
+#endif
+
+// Бюджет памяти каждого кэша по умолчанию в байтах (0 - без ограничения)
+#ifndef FEELMEHAPPY_CACHE_BUDGET
+    #define FEELMEHAPPY_CACHE_BUDGET (64u * 1024u * 1024u)
+#endif
+
+// Сколько обращений нужно строке, чтобы попасть в кэш (1 - сохранять сразу)
+#ifndef FEELMEHAPPY_CACHE_ADMISSION
+    #define FEELMEHAPPY_CACHE_ADMISSION 2
+#endif
+
+// Сколько самых востребованных строк пересчитывается под следующий ключ
+// и за сколько миллисекунд до ротации (0 ключей - без подготовки)
+#ifndef FEELMEHAPPY_PREWARM_KEYS
+    #define FEELMEHAPPY_PREWARM_KEYS 256
+#endif
+#ifndef FEELMEHAPPY_PREWARM_LEAD_MS
+    #define FEELMEHAPPY_PREWARM_LEAD_MS 10000
+#endif
+
+// Размер части при потоковой обфускации; куски от двух частей
+// обрабатываются параллельно
+#ifndef FEELMEHAPPY_STREAM_CHUNK
+    #define FEELMEHAPPY_STREAM_CHUNK (1u << 20)
+#endif
+
+// Потоков в общем пуле, 0 - по числу ядер минус вызывающий поток
+#ifndef FEELMEHAPPY_WORKER_THREADS
+    #define FEELMEHAPPY_WORKER_THREADS 0
+#endif
+
+// 0 - без фонового потока: ротация ключа, генерация функций и очистка
+// кэшей выполняются только при вызовах UniversalObfuscator::tick()
+#ifndef FEELMEHAPPY_BACKGROUND_THREAD
+    #define FEELMEHAPPY_BACKGROUND_THREAD 1
+#endif
+
+// 0 - без счётчиков преобразований и замеров ожидания блокировок
+#ifndef FEELMEHAPPY_METRICS
+    #define FEELMEHAPPY_METRICS 1
+#endif
+
+// 1 - профиль по местам вызова FEEL: гистограмма задержек, попадания и
+// промахи для каждой пары __FILE__/__LINE__. Замеряется каждый
+// FEELMEHAPPY_PROFILE_SAMPLE-й вызов в потоке (1 - каждый вызов).
+#ifndef FEELMEHAPPY_PROFILE_SITES
+    #define FEELMEHAPPY_PROFILE_SITES 0
+#endif
+#ifndef FEELMEHAPPY_PROFILE_SAMPLE
+    #define FEELMEHAPPY_PROFILE_SAMPLE 256
+#endif
+
 // ==================== УНИВЕРСАЛЬНЫЙ МАКРОС FEEL ====================
 
 #ifdef _DEBUG
     // Режим отладки - без обфускации
     #define FEEL(...) __VA_ARGS__
 #else
-    // Релиз режим - автоматическая обфускация всего
-    #define FEEL(...) _feel_me_happy_::UniversalObfuscator::obfuscate(__VA_ARGS__)
+    // Релиз режим - автоматическая обфускация всего.
+    // Строковые литералы шифруются на этапе компиляции и не проходят
+    // через кэш, детектор типов и блокировки: результат хранится в слоте
+    // места вызова до смены ключа. Остальное идёт в obfuscate().
+    // Лямбда без захвата допустима и на уровне пространства имён, поэтому
+    // значение приходит параметром, а текст литерала восстанавливается из
+    // #__VA_ARGS__. Промежуточный макрос раскрывает макросы в аргументе.
+    #define FEEL(...) FEELMEHAPPY_FEEL(__VA_ARGS__)
+    #define FEELMEHAPPY_FEEL(...) ([](auto _feel_tag_, auto&& _feel_value_) -> decltype(auto) {     \
+        FEELMEHAPPY_SITE_SCOPE                                                                     \
+        using _FeelTag_ = decltype(_feel_tag_);                                                    \
+        using _FeelLiteral_ = ::_feel_me_happy_::IsStringLiteral<decltype(_feel_value_), _FeelTag_>; \
+        static constexpr auto _feel_text_ =                                                        \
+            ::_feel_me_happy_::LiteralCipher::parse<_FeelLiteral_>(#__VA_ARGS__);                  \
+        if constexpr (_feel_text_.valid) {                                                         \
+            static constexpr auto _feel_literal_ = ::_feel_me_happy_::LiteralCipher::encrypt(      \
+                _feel_text_, ::_feel_me_happy_::LiteralCipher::seed(__FILE__, __LINE__, __COUNTER__)); \
+            thread_local typename std::remove_const_t<decltype(_feel_literal_)>::Slot _feel_slot_;  \
+            return ::_feel_me_happy_::UniversalObfuscator::obfuscateLiteral(_feel_literal_, _feel_slot_); \
+        } else {                                                                                   \
+            using _FeelObfuscator_ = typename ::_feel_me_happy_::DependentType<                    \
+                ::_feel_me_happy_::UniversalObfuscator, _FeelTag_>::type;                         \
+            return _FeelObfuscator_::obfuscate(std::forward<decltype(_feel_value_)>(_feel_value_)); \
+        }                                                                                          \
+    }(0, (__VA_ARGS__)))
+    
+    // Место вызова - статический объект внутри лямбды FEEL
+    #if FEELMEHAPPY_PROFILE_SITES
+        #define FEELMEHAPPY_SITE_SCOPE                                                             \
+            static ::_feel_me_happy_::CallSite _feel_site_(__FILE__, __LINE__);                    \
+            ::_feel_me_happy_::CallSiteScope _feel_scope_(_feel_site_);
+    #else
+        #define FEELMEHAPPY_SITE_SCOPE
+    #endif
 #endif
 
 namespace _feel_me_happy_ {
@@ -92,6 +221,97 @@ using DWord = uint32_t;
 using QWord = uint64_t;
 using Size = size_t;
 
+// Возможности процессора, определяются один раз при первом обращении
+class CpuFeatures {
+public:
+    static bool hasSSE2() {
+#ifdef FEELMEHAPPY_SSE2
+        return true;
+#else
+        return false;
+#endif
+    }
+    
+    static bool hasAVX2() {
+        static const bool supported = detectAVX2();
+        return supported;
+    }
+    
+    // AVX-512 с байтовыми операциями (F + BW)
+    static bool hasAVX512() {
+        static const bool supported = detectAVX512();
+        return supported;
+    }
+    
+    static bool hasNEON() {
+#ifdef FEELMEHAPPY_NEON
+        return true;
+#else
+        return false;
+#endif
+    }
+    
+private:
+    static bool detectAVX2() {
+#if defined(FEELMEHAPPY_AVX2) && defined(_MSC_VER)
+        int regs[4];
+        __cpuid(regs, 0);
+        if (regs[0] < 7) return false;
+        __cpuid(regs, 1);
+        bool osxsave = (regs[2] & (1 << 27)) != 0;
+        if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) return false;
+        __cpuidex(regs, 7, 0);
+        return (regs[1] & (1 << 5)) != 0;
+#elif defined(FEELMEHAPPY_AVX2)
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+    
+    static bool detectAVX512() {
+#if defined(FEELMEHAPPY_AVX512) && defined(_MSC_VER)
+        int regs[4];
+        __cpuid(regs, 0);
+        if (regs[0] < 7) return false;
+        __cpuid(regs, 1);
+        bool osxsave = (regs[2] & (1 << 27)) != 0;
+        // Состояние XMM/YMM и регистров opmask/ZMM сохраняется ОС
+        if (!osxsave || (_xgetbv(0) & 0xE6) != 0xE6) return false;
+        __cpuidex(regs, 7, 0);
+        return (regs[1] & (1 << 16)) != 0 && (regs[1] & (1 << 30)) != 0;
+#elif defined(FEELMEHAPPY_AVX512)
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#else
+        return false;
+#endif
+    }
+};
+
+// Битовые утилиты без зависимости от POPCNT/BMI
+inline Size popCount(DWord mask) {
+    mask = mask - ((mask >> 1) & 0x55555555u);
+    mask = (mask & 0x33333333u) + ((mask >> 2) & 0x33333333u);
+    return (((mask + (mask >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+}
+
+inline Size countTrailingZeros(DWord mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+inline Size countTrailingZeros(QWord mask) {
+    DWord low = static_cast<DWord>(mask);
+    return low ? countTrailingZeros(low) : 32 + countTrailingZeros(static_cast<DWord>(mask >> 32));
+}
+
 // Детектор типов
 class TypeDetector {
 public:
@@ -149,133 +369,568 @@ public:
         }
     }
 
+    // Классификация без аллокаций и регулярных выражений, пригодна для constexpr.
+    // Схема URL проверяется раньше путей: "//" в ней иначе всегда давал Path.
+    static constexpr DataType classify(const char* s, Size n) {
+        if (!s) return DataType::Unknown;
+
+        if (isURL(s, n)) return DataType::URL;
+
+        if (contains(s, n, "/") || contains(s, n, "\\") ||
+            contains(s, n, ".cpp") || contains(s, n, ".h") ||
+            contains(s, n, ".exe") || contains(s, n, ".dll")) {
+            return DataType::Path;
+        }
+
+        if (isEmail(s, n)) return DataType::Email;
+        if (isIP(s, n)) return DataType::IP;
+        if (isHex(s, n)) return DataType::Hex;
+        if (isBase64(s, n)) return DataType::Base64;
+
+        if (containsNoCase(s, n, "select ") || containsNoCase(s, n, "insert ") ||
+            containsNoCase(s, n, "update ") || containsNoCase(s, n, "delete ") ||
+            containsNoCase(s, n, "create ") || containsNoCase(s, n, "drop ")) {
+            return DataType::SQL;
+        }
+
+        if ((contains(s, n, "{") && contains(s, n, "}")) ||
+            (contains(s, n, "[") && contains(s, n, "]"))) {
+            return DataType::JSON;
+        }
+
+        if (contains(s, n, "<?xml") || (contains(s, n, "<") && contains(s, n, ">"))) {
+            return DataType::XML;
+        }
+
+        if (contains(s, n, "#include") || contains(s, n, "int ") ||
+            contains(s, n, "void ") || contains(s, n, "return ") ||
+            contains(s, n, "if (") || contains(s, n, "for (") ||
+            contains(s, n, "while (")) {
+            return DataType::Code;
+        }
+
+        return DataType::CString;
+    }
+
+    static constexpr Size length(const char* s) {
+        Size n = 0;
+        while (s[n]) ++n;
+        return n;
+    }
+
 private:
+    // Вспомогательные constexpr-функции для classify
+    static constexpr char toLower(char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    static constexpr bool isDigit(char c) { return c >= '0' && c <= '9'; }
+    static constexpr bool isAlpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+    static constexpr bool isAlnum(char c) { return isDigit(c) || isAlpha(c); }
+    static constexpr bool isHexDigit(char c) {
+        return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+    }
+
+    static constexpr bool matchAt(const char* s, Size n, Size pos, const char* pattern, bool noCase) {
+        Size i = 0;
+        for (; pattern[i]; ++i) {
+            if (pos + i >= n) return false;
+            char c = noCase ? toLower(s[pos + i]) : s[pos + i];
+            if (c != pattern[i]) return false;
+        }
+        return true;
+    }
+
+    static constexpr bool contains(const char* s, Size n, const char* pattern) {
+        for (Size pos = 0; pos < n; ++pos) {
+            if (matchAt(s, n, pos, pattern, false)) return true;
+        }
+        return false;
+    }
+
+    static constexpr bool containsNoCase(const char* s, Size n, const char* pattern) {
+        for (Size pos = 0; pos < n; ++pos) {
+            if (matchAt(s, n, pos, pattern, true)) return true;
+        }
+        return false;
+    }
+
+    static constexpr bool startsWith(const char* s, Size n, const char* pattern) {
+        return matchAt(s, n, 0, pattern, false);
+    }
+
+    static constexpr bool isURL(const char* s, Size n) {
+        return startsWith(s, n, "http://") || startsWith(s, n, "https://") ||
+               startsWith(s, n, "ftp://") || startsWith(s, n, "file://");
+    }
+
+    // [a-zA-Z0-9._%+-]+@[a-zA-Z0-9.-]+\.[a-zA-Z]{2,}
+    static constexpr bool isEmail(const char* s, Size n) {
+        Size at = n;
+        for (Size i = 0; i < n; ++i) {
+            char c = s[i];
+            if (c == '@') {
+                if (at != n) return false;
+                at = i;
+            } else if (at == n) {
+                if (!(isAlnum(c) || c == '.' || c == '_' || c == '%' || c == '+' || c == '-')) return false;
+            } else {
+                if (!(isAlnum(c) || c == '.' || c == '-')) return false;
+            }
+        }
+        if (at == 0 || at == n) return false;
+
+        Size dot = n;
+        for (Size i = n; i > at + 1; --i) {
+            if (s[i - 1] == '.') {
+                dot = i - 1;
+                break;
+            }
+        }
+        if (dot == n || dot < at + 2 || n - dot - 1 < 2) return false;
+        for (Size i = dot + 1; i < n; ++i) {
+            if (!isAlpha(s[i])) return false;
+        }
+        return true;
+    }
+
+    // (\d{1,3}\.){3}\d{1,3}
+    static constexpr bool isIP(const char* s, Size n) {
+        Size groups = 0;
+        Size digits = 0;
+        for (Size i = 0; i < n; ++i) {
+            if (isDigit(s[i])) {
+                if (++digits > 3) return false;
+            } else if (s[i] == '.') {
+                if (digits == 0 || ++groups > 3) return false;
+                digits = 0;
+            } else {
+                return false;
+            }
+        }
+        return groups == 3 && digits > 0;
+    }
+
+    // ^[0-9a-fA-F]+$
+    static constexpr bool isHex(const char* s, Size n) {
+        if (n == 0) return false;
+        for (Size i = 0; i < n; ++i) {
+            if (!isHexDigit(s[i])) return false;
+        }
+        return true;
+    }
+
+    // ^[A-Za-z0-9+/]+={0,2}$ при длине, кратной 4
+    static constexpr bool isBase64(const char* s, Size n) {
+        if (n % 4 != 0) return false;
+        Size core = n;
+        while (core > 0 && s[core - 1] == '=') --core;
+        if (core == 0 || n - core > 2) return false;
+        for (Size i = 0; i < core; ++i) {
+            if (!(isAlnum(s[i]) || s[i] == '+' || s[i] == '/')) return false;
+        }
+        return true;
+    }
+
     static DataType analyzeCString(const char* str) {
         if (!str) return DataType::Unknown;
+        return classifyWith(activeKernel(), str, std::strlen(str));
+    }
+    
+    static DataType analyzeStdString(const std::string& s) {
+        // Аналогично анализу C-строк
+        return analyzeCString(s.c_str());
+    }
+
+    // ---------- Однопроходный классификатор на SIMD ----------
+    //
+    // Ядро формирует битовые маски классов символов для блока из 32 байт,
+    // общий накопитель объединяет их и проверяет ключевые слова только
+    // в позициях-кандидатах ('.', ' ', '#', '<').
+
+    enum CharClass {
+        Slash, Backslash, Dot, At, LBrace, RBrace, LBrack, RBrack,
+        Lt, Gt, Hash, Space, Eq, Plus, EmailPunct, Digit, Alpha, HexAlpha,
+        CharClassCount
+    };
+
+    struct BlockMasks {
+        DWord bits[CharClassCount];
+    };
+
+    struct ScanState {
+        bool slash = false, backslash = false;
+        bool lbrace = false, rbrace = false, lbrack = false, rbrack = false;
+        bool lt = false, gt = false;
+        bool pathExt = false, sql = false, code = false, xmlDecl = false;
+        DWord notHex = 0, notIP = 0, notBase64 = 0, notEmail = 0;
+        Size atCount = 0, dotCount = 0, eqCount = 0;
+    };
+
+    static constexpr Size kBlockSize = 32;
+
+public:
+    enum class Kernel { Scalar, SSE2, AVX2, NEON };
+
+    static bool kernelSupported(Kernel kernel) {
+        switch (kernel) {
+            case Kernel::Scalar: return true;
+            case Kernel::SSE2: return CpuFeatures::hasSSE2();
+            case Kernel::AVX2: return CpuFeatures::hasAVX2();
+            case Kernel::NEON: return CpuFeatures::hasNEON();
+        }
+        return false;
+    }
+
+    // Лучшее доступное ядро, выбирается один раз
+    static Kernel activeKernel() {
+        static const Kernel kernel = kernelSupported(Kernel::AVX2) ? Kernel::AVX2 :
+                                     kernelSupported(Kernel::SSE2) ? Kernel::SSE2 :
+                                     kernelSupported(Kernel::NEON) ? Kernel::NEON : Kernel::Scalar;
+        return kernel;
+    }
+
+    static DataType classifyWith(Kernel kernel, const char* s, Size n) {
+        if (!s) return DataType::Unknown;
+        switch (kernel) {
+#ifdef FEELMEHAPPY_SSE2
+            case Kernel::SSE2: return scan(s, n, &masksSSE2);
+#endif
+#ifdef FEELMEHAPPY_AVX2
+            case Kernel::AVX2: return scan(s, n, &masksAVX2);
+#endif
+#ifdef FEELMEHAPPY_NEON
+            case Kernel::NEON: return scan(s, n, &masksNEON);
+#endif
+            default: return scan(s, n, &masksScalar);
+        }
+    }
+
+private:
+    using MaskKernel = void (*)(const char*, BlockMasks&);
+
+    static DataType scan(const char* s, Size n, MaskKernel kernel) {
+        if (isURL(s, n)) return DataType::URL;
         
-        std::string s(str);
+        ScanState state;
+        BlockMasks masks;
+        Size pos = 0;
         
-        // Проверка на пути
-        if (s.find("/") != std::string::npos || 
-            s.find("\\") != std::string::npos ||
-            s.find(".") != std::string::npos && 
-            (s.find(".cpp") != std::string::npos ||
-             s.find(".h") != std::string::npos ||
-             s.find(".exe") != std::string::npos ||
-             s.find(".dll") != std::string::npos)) {
-            return DataType::Path;
+        for (; pos + kBlockSize <= n; pos += kBlockSize) {
+            kernel(s + pos, masks);
+            if (consume(state, masks, s, n, pos, 0xFFFFFFFFu)) return DataType::Path;
         }
         
-        // Проверка на URL
-        if (s.find("http://") == 0 || s.find("https://") == 0 ||
-            s.find("ftp://") == 0 || s.find("file://") == 0) {
-            return DataType::URL;
+        if (pos < n) {
+            // Хвост копируется в обнулённый блок, лишние позиции отсекаются маской
+            char tail[kBlockSize] = {};
+            std::memcpy(tail, s + pos, n - pos);
+            kernel(tail, masks);
+            if (consume(state, masks, s, n, pos, (1u << (n - pos)) - 1)) return DataType::Path;
         }
         
-        // Проверка на email
-        static std::regex email_regex(R"([a-zA-Z0-9._%+-]+@[a-zA-Z0-9.-]+\.[a-zA-Z]{2,})");
-        if (std::regex_match(s, email_regex)) {
-            return DataType::Email;
-        }
+        return finish(state, s, n);
+    }
+
+    // Возвращает true, если строка уже однозначно является путём
+    static bool consume(ScanState& st, const BlockMasks& masks, const char* s, Size n, Size base, DWord valid) {
+        const DWord* m = masks.bits;
+        st.slash |= (m[Slash] & valid) != 0;
+        st.backslash |= (m[Backslash] & valid) != 0;
         
-        // Проверка на IP
-        static std::regex ip_regex(R"((\d{1,3}\.){3}\d{1,3})");
-        if (std::regex_match(s, ip_regex)) {
-            return DataType::IP;
+        for (DWord bits = m[Dot] & valid; bits; bits &= bits - 1) {
+            Size p = base + countTrailingZeros(bits);
+            if (matchAt(s, n, p, ".cpp", false) || matchAt(s, n, p, ".h", false) ||
+                matchAt(s, n, p, ".exe", false) || matchAt(s, n, p, ".dll", false)) {
+                st.pathExt = true;
+            }
         }
+        if (st.slash || st.backslash || st.pathExt) return true;
         
-        // Проверка на hex
-        static std::regex hex_regex(R"(^[0-9a-fA-F]+$)");
-        if (std::regex_match(s, hex_regex)) {
-            return DataType::Hex;
-        }
+        st.lbrace |= (m[LBrace] & valid) != 0;
+        st.rbrace |= (m[RBrace] & valid) != 0;
+        st.lbrack |= (m[LBrack] & valid) != 0;
+        st.rbrack |= (m[RBrack] & valid) != 0;
+        st.lt |= (m[Lt] & valid) != 0;
+        st.gt |= (m[Gt] & valid) != 0;
         
-        // Проверка на base64
-        static std::regex base64_regex(R"(^[A-Za-z0-9+/]+={0,2}$)");
-        if (s.length() % 4 == 0 && std::regex_match(s, base64_regex)) {
-            return DataType::Base64;
-        }
+        DWord alnum = m[Digit] | m[Alpha];
+        st.notHex |= ~(m[Digit] | m[HexAlpha]) & valid;
+        st.notIP |= ~(m[Digit] | m[Dot]) & valid;
+        st.notBase64 |= ~(alnum | m[Plus] | m[Slash] | m[Eq]) & valid;
+        st.notEmail |= ~(alnum | m[Dot] | m[At] | m[Plus] | m[EmailPunct]) & valid;
+        st.atCount += popCount(m[At] & valid);
+        st.dotCount += popCount(m[Dot] & valid);
+        st.eqCount += popCount(m[Eq] & valid);
         
-        // Проверка на SQL
-        std::string lower = s;
-        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
-        if (lower.find("select ") != std::string::npos ||
-            lower.find("insert ") != std::string::npos ||
-            lower.find("update ") != std::string::npos ||
-            lower.find("delete ") != std::string::npos ||
-            lower.find("create ") != std::string::npos ||
-            lower.find("drop ") != std::string::npos) {
-            return DataType::SQL;
+        for (DWord bits = m[Space] & valid; bits; bits &= bits - 1) {
+            Size p = base + countTrailingZeros(bits);
+            // Ключевые слова перед пробелом оканчиваются на t, e, p, d, n, а перед "(" на f, r, e
+            char last = p > 0 ? toLower(s[p - 1]) : '\0';
+            if (last != 't' && last != 'e' && last != 'p' && last != 'd' && last != 'n' &&
+                last != 'f' && last != 'r') {
+                continue;
+            }
+            if (!st.sql) {
+                st.sql = (p >= 6 && (matchAt(s, n, p - 6, "select", true) || matchAt(s, n, p - 6, "insert", true) ||
+                                     matchAt(s, n, p - 6, "update", true) || matchAt(s, n, p - 6, "delete", true) ||
+                                     matchAt(s, n, p - 6, "create", true))) ||
+                         (p >= 4 && matchAt(s, n, p - 4, "drop", true));
+            }
+            if (!st.code) {
+                st.code = (p >= 3 && matchAt(s, n, p - 3, "int", false)) ||
+                          (p >= 4 && matchAt(s, n, p - 4, "void", false)) ||
+                          (p >= 6 && matchAt(s, n, p - 6, "return", false));
+                if (!st.code && p + 1 < n && s[p + 1] == '(') {
+                    st.code = (p >= 2 && matchAt(s, n, p - 2, "if", false)) ||
+                              (p >= 3 && matchAt(s, n, p - 3, "for", false)) ||
+                              (p >= 5 && matchAt(s, n, p - 5, "while", false));
+                }
+            }
         }
-        
-        // Проверка на JSON/XML
-        if ((s.find("{") != std::string::npos && s.find("}") != std::string::npos) ||
-            (s.find("[") != std::string::npos && s.find("]") != std::string::npos)) {
-            return DataType::JSON;
+        for (DWord bits = m[Hash] & valid; bits && !st.code; bits &= bits - 1) {
+            st.code = matchAt(s, n, base + countTrailingZeros(bits), "#include", false);
         }
-        
-        if (s.find("<?xml") != std::string::npos || 
-            s.find("<") != std::string::npos && s.find(">") != std::string::npos) {
-            return DataType::XML;
+        for (DWord bits = m[Lt] & valid; bits && !st.xmlDecl; bits &= bits - 1) {
+            st.xmlDecl = matchAt(s, n, base + countTrailingZeros(bits), "<?xml", false);
+        }
+        return false;
+    }
+
+    static DataType finish(const ScanState& st, const char* s, Size n) {
+        if (!st.notEmail && st.atCount == 1 && isEmail(s, n)) return DataType::Email;
+        if (!st.notIP && st.dotCount == 3 && isIP(s, n)) return DataType::IP;
+        if (!st.notHex && n > 0) return DataType::Hex;
+        if (!st.notBase64 && n % 4 == 0) {
+            // Все символы допустимы, остаётся проверить, что '=' только в конце
+            Size padding = 0;
+            while (padding < n && s[n - 1 - padding] == '=') ++padding;
+            if (padding == st.eqCount && padding <= 2 && padding < n) return DataType::Base64;
         }
+        if (st.sql) return DataType::SQL;
+        if ((st.lbrace && st.rbrace) || (st.lbrack && st.rbrack)) return DataType::JSON;
+        if (st.xmlDecl || (st.lt && st.gt)) return DataType::XML;
+        if (st.code) return DataType::Code;
+        return DataType::CString;
+    }
+
+    // Таблица классов символов для скалярного ядра
+    struct ClassTable {
+        DWord flags[256] = {};
         
-        // Проверка на код
-        if (s.find("#include") != std::string::npos ||
-            s.find("int ") != std::string::npos ||
-            s.find("void ") != std::string::npos ||
-            s.find("return ") != std::string::npos ||
-            s.find("if (") != std::string::npos ||
-            s.find("for (") != std::string::npos ||
-            s.find("while (") != std::string::npos) {
-            return DataType::Code;
+        constexpr ClassTable() {
+            const char singles[] = {'/', '\\', '.', '@', '{', '}', '[', ']', '<', '>', '#', ' ', '=', '+'};
+            const CharClass classes[] = {Slash, Backslash, Dot, At, LBrace, RBrace, LBrack, RBrack,
+                                         Lt, Gt, Hash, Space, Eq, Plus};
+            for (Size i = 0; i < sizeof(singles); ++i) {
+                flags[static_cast<Byte>(singles[i])] |= 1u << classes[i];
+            }
+            flags[static_cast<Byte>('_')] |= 1u << EmailPunct;
+            flags[static_cast<Byte>('%')] |= 1u << EmailPunct;
+            flags[static_cast<Byte>('-')] |= 1u << EmailPunct;
+            for (int c = 0; c < 256; ++c) {
+                char ch = static_cast<char>(c);
+                if (isDigit(ch)) flags[c] |= 1u << Digit;
+                if (isAlpha(ch)) flags[c] |= 1u << Alpha;
+                if (isHexDigit(ch) && !isDigit(ch)) flags[c] |= 1u << HexAlpha;
+            }
         }
+    };
+
+    static void masksScalar(const char* p, BlockMasks& m) {
+        static constexpr ClassTable table{};
+        m = BlockMasks{};
+        for (Size j = 0; j < kBlockSize; ++j) {
+            for (DWord f = table.flags[static_cast<Byte>(p[j])]; f; f &= f - 1) {
+                m.bits[countTrailingZeros(f)] |= 1u << j;
+            }
+        }
+    }
+
+#ifdef FEELMEHAPPY_SSE2
+    static void masksSSE2Half(__m128i v, BlockMasks& m, int shift) {
+        auto move = [shift](__m128i x) { return static_cast<DWord>(_mm_movemask_epi8(x) & 0xFFFF) << shift; };
+        auto eq = [v](char c) { return _mm_cmpeq_epi8(v, _mm_set1_epi8(c)); };
+        auto range = [](__m128i x, char lo, char hi) {
+            return _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8(static_cast<char>(lo - 1))),
+                                 _mm_cmplt_epi8(x, _mm_set1_epi8(static_cast<char>(hi + 1))));
+        };
+        __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
         
-        return DataType::CString;
+        m.bits[Slash] |= move(eq('/'));
+        m.bits[Backslash] |= move(eq('\\'));
+        m.bits[Dot] |= move(eq('.'));
+        m.bits[At] |= move(eq('@'));
+        m.bits[LBrace] |= move(eq('{'));
+        m.bits[RBrace] |= move(eq('}'));
+        m.bits[LBrack] |= move(eq('['));
+        m.bits[RBrack] |= move(eq(']'));
+        m.bits[Lt] |= move(eq('<'));
+        m.bits[Gt] |= move(eq('>'));
+        m.bits[Hash] |= move(eq('#'));
+        m.bits[Space] |= move(eq(' '));
+        m.bits[Eq] |= move(eq('='));
+        m.bits[Plus] |= move(eq('+'));
+        m.bits[EmailPunct] |= move(_mm_or_si128(_mm_or_si128(eq('_'), eq('%')), eq('-')));
+        m.bits[Digit] |= move(range(v, '0', '9'));
+        m.bits[Alpha] |= move(range(lower, 'a', 'z'));
+        m.bits[HexAlpha] |= move(range(lower, 'a', 'f'));
     }
-    
-    static DataType analyzeStdString(const std::string& s) {
-        // Аналогично анализу C-строк
-        return analyzeCString(s.c_str());
+
+    static void masksSSE2(const char* p, BlockMasks& m) {
+        m = BlockMasks{};
+        masksSSE2Half(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), m, 0);
+        masksSSE2Half(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16)), m, 16);
+    }
+#endif
+
+#ifdef FEELMEHAPPY_AVX2
+    FEELMEHAPPY_TARGET_AVX2 static void masksAVX2(const char* p, BlockMasks& m) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        
+        #define FEELMEHAPPY_EQ256(c) _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))
+        #define FEELMEHAPPY_RANGE256(x, lo, hi) _mm256_and_si256(                         \
+            _mm256_cmpgt_epi8(x, _mm256_set1_epi8(static_cast<char>((lo) - 1))),         \
+            _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>((hi) + 1)), x))
+        #define FEELMEHAPPY_MOVE256(x) static_cast<DWord>(_mm256_movemask_epi8(x))
+        
+        m.bits[Slash] = FEELMEHAPPY_MOVE256(FEELMEHAPPY_EQ256('/'));
+        m.bits[Backslash] = FEELMEHAPPY_MOVE256(FEELMEHAPPY_EQ256('\\'));
+        m.bits[Dot] = FEELMEHAPPY_MOVE256(FEELMEHAPPY_EQ256('.'));
+        m.bits[At] = FEELMEHAPPY_MOVE256(FEELMEHAPPY_EQ256('@'));
+        m.bits[LBrace] = FEELMEHAPPY_MOVE256(FEELMEHAPPY_EQ256('{'));
+        m.bits[RBrace] = FEELMEHAPPY_MOVE256(FEELMEHAPPY_EQ256('}'));
+        m.bits[LBrack] = FEELMEHAPPY_MOVE256(FEELMEHAPPY_EQ256('['));
+        m.bits[RBrack] = FEELMEHAPPY_MOVE256(FEELMEHAPPY_EQ256(']'));
+        m.bits[Lt] = FEELMEHAPPY_MOVE256(FEELMEHAPPY_EQ256('<'));
+        m.bits[Gt] = FEELMEHAPPY_MOVE256(FEELMEHAPPY_EQ256('>'));
+        m.bits[Hash] = FEELMEHAPPY_MOVE256(FEELMEHAPPY_EQ256('#'));
+        m.bits[Space] = FEELMEHAPPY_MOVE256(FEELMEHAPPY_EQ256(' '));
+        m.bits[Eq] = FEELMEHAPPY_MOVE256(FEELMEHAPPY_EQ256('='));
+        m.bits[Plus] = FEELMEHAPPY_MOVE256(FEELMEHAPPY_EQ256('+'));
+        m.bits[EmailPunct] = FEELMEHAPPY_MOVE256(_mm256_or_si256(_mm256_or_si256(
+            FEELMEHAPPY_EQ256('_'), FEELMEHAPPY_EQ256('%')), FEELMEHAPPY_EQ256('-')));
+        m.bits[Digit] = FEELMEHAPPY_MOVE256(FEELMEHAPPY_RANGE256(v, '0', '9'));
+        m.bits[Alpha] = FEELMEHAPPY_MOVE256(FEELMEHAPPY_RANGE256(lower, 'a', 'z'));
+        m.bits[HexAlpha] = FEELMEHAPPY_MOVE256(FEELMEHAPPY_RANGE256(lower, 'a', 'f'));
+        
+        #undef FEELMEHAPPY_EQ256
+        #undef FEELMEHAPPY_RANGE256
+        #undef FEELMEHAPPY_MOVE256
+    }
+#endif
+
+#ifdef FEELMEHAPPY_NEON
+    static DWord movemaskNEON(uint8x16_t v) {
+        static const uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+        uint8x16_t bits = vandq_u8(v, vld1q_u8(weights));
+        return static_cast<DWord>(vaddv_u8(vget_low_u8(bits))) |
+               (static_cast<DWord>(vaddv_u8(vget_high_u8(bits))) << 8);
+    }
+
+    static void masksNEONHalf(uint8x16_t v, BlockMasks& m, int shift) {
+        auto move = [shift](uint8x16_t x) { return movemaskNEON(x) << shift; };
+        auto eq = [v](char c) { return vceqq_u8(v, vdupq_n_u8(static_cast<uint8_t>(c))); };
+        auto range = [](uint8x16_t x, char lo, char hi) {
+            return vandq_u8(vcgeq_u8(x, vdupq_n_u8(static_cast<uint8_t>(lo))),
+                            vcleq_u8(x, vdupq_n_u8(static_cast<uint8_t>(hi))));
+        };
+        uint8x16_t lower = vorrq_u8(v, vdupq_n_u8(0x20));
+        
+        m.bits[Slash] |= move(eq('/'));
+        m.bits[Backslash] |= move(eq('\\'));
+        m.bits[Dot] |= move(eq('.'));
+        m.bits[At] |= move(eq('@'));
+        m.bits[LBrace] |= move(eq('{'));
+        m.bits[RBrace] |= move(eq('}'));
+        m.bits[LBrack] |= move(eq('['));
+        m.bits[RBrack] |= move(eq(']'));
+        m.bits[Lt] |= move(eq('<'));
+        m.bits[Gt] |= move(eq('>'));
+        m.bits[Hash] |= move(eq('#'));
+        m.bits[Space] |= move(eq(' '));
+        m.bits[Eq] |= move(eq('='));
+        m.bits[Plus] |= move(eq('+'));
+        m.bits[EmailPunct] |= move(vorrq_u8(vorrq_u8(eq('_'), eq('%')), eq('-')));
+        m.bits[Digit] |= move(range(v, '0', '9'));
+        m.bits[Alpha] |= move(range(lower, 'a', 'z'));
+        m.bits[HexAlpha] |= move(range(lower, 'a', 'f'));
     }
+
+    static void masksNEON(const char* p, BlockMasks& m) {
+        m = BlockMasks{};
+        masksNEONHalf(vld1q_u8(reinterpret_cast<const uint8_t*>(p)), m, 0);
+        masksNEONHalf(vld1q_u8(reinterpret_cast<const uint8_t*>(p + 16)), m, 16);
+    }
+#endif
 };
 
 // Генератор случайных ключей
 class KeyGenerator {
 private:
-    static std::mt19937_64 engine;
-    static std::mutex mutex;
+    // Центральный сидер: каждый поток берёт из него одно зерно
+    inline static std::atomic<QWord> seedState{
+        (static_cast<QWord>(std::random_device{}()) << 32) ^ std::random_device{}()};
+    
+    static QWord nextSeed() {
+        // splitmix64, чтобы зёрна соседних потоков не коррелировали
+        QWord z = seedState.fetch_add(0x9E3779B97F4A7C15ull, std::memory_order_relaxed);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    
+    // Свой генератор в каждом потоке, без общей блокировки
+    static std::mt19937_64& engine() {
+        thread_local std::mt19937_64 local(nextSeed());
+        return local;
+    }
     
 public:
     static Byte generateByte() {
-        std::lock_guard<std::mutex> lock(mutex);
-        return static_cast<Byte>(engine() & 0xFF);
+        return static_cast<Byte>(engine()() & 0xFF);
     }
     
     static Word generateWord() {
-        std::lock_guard<std::mutex> lock(mutex);
-        return static_cast<Word>(engine() & 0xFFFF);
+        return static_cast<Word>(engine()() & 0xFFFF);
     }
     
     static DWord generateDWord() {
-        std::lock_guard<std::mutex> lock(mutex);
-        return static_cast<DWord>(engine() & 0xFFFFFFFF);
+        return static_cast<DWord>(engine()() & 0xFFFFFFFF);
     }
     
     static QWord generateQWord() {
-        std::lock_guard<std::mutex> lock(mutex);
-        return engine();
+        return engine()();
     }
     
+    // Каждый выход генератора даёт 8 байт
     static void generateBytes(Byte* buffer, Size size) {
-        std::lock_guard<std::mutex> lock(mutex);
-        for (Size i = 0; i < size; ++i) {
-            buffer[i] = static_cast<Byte>(engine() & 0xFF);
+        std::mt19937_64& local = engine();
+        Size i = 0;
+        for (; i + sizeof(QWord) <= size; i += sizeof(QWord)) {
+            QWord value = local();
+            std::memcpy(buffer + i, &value, sizeof(QWord));
+        }
+        if (i < size) {
+            QWord value = local();
+            std::memcpy(buffer + i, &value, size - i);
         }
     }
 };
 
-std::mt19937_64 KeyGenerator::engine(std::random_device{}());
-std::mutex KeyGenerator::mutex;
+template<typename To, typename From>
+#ifdef FEELMEHAPPY_BIT_CAST_CONSTEXPR
+constexpr To bitCast(const From& from) {
+    return __builtin_bit_cast(To, from);
+}
+#else
+To bitCast(const From& from) {
+    To to;
+    std::memcpy(&to, &from, sizeof(To));
+    return to;
+}
+#endif
 
 // Алгоритмы обфускации
 class ObfuscationAlgorithms {
@@ -338,87 +993,3168 @@ public:
         return ~data;
     }
     
-    // Комбинированная обфускация для строк
-    static std::string obfuscateString(const std::string& str, Byte key) {
-        std::string result = str;
-        for (Size i = 0; i < result.size(); ++i) {
-            result[i] ^= key ^ (i * 0x37);
-            result[i] += (i % 0xFF);
-            result[i] = (result[i] << 3) | (result[i] >> 5);
-        }
-        return result;
-    }
+    // ==== Скалярный путь ====
     
-    static std::wstring obfuscateWString(const std::wstring& str, Byte key) {
-        std::wstring result = str;
-        for (Size i = 0; i < result.size(); ++i) {
-            result[i] ^= key ^ (i * 0x37);
-            result[i] += (i % 0xFFFF);
-            result[i] = (result[i] << 3) | (result[i] >> 13);
+    // Слово, в байте i которого лежит i * step
+    template<typename U>
+    static constexpr U byteRamp(Byte step) {
+        U ramp = 0;
+        for (Size i = 0; i < sizeof(U); ++i) {
+            ramp |= static_cast<U>(static_cast<U>(static_cast<Byte>(i * step)) << (8 * i));
         }
-        return result;
+        return ramp;
     }
-};
-
-// Кэш обфусцированных данных
-template<typename Key, typename Value>
-class ObfuscationCache {
-private:
-    struct CacheEntry {
-        Value data;
-        std::chrono::steady_clock::time_point timestamp;
-        Byte key;
-    };
     
-    std::unordered_map<Key, CacheEntry> cache;
-    std::mutex mutex;
-    const std::chrono::minutes cacheDuration{15};
+    // Побайтное сложение по модулю 256 без переносов между байтами
+    template<typename U>
+    static constexpr U addBytes(U a, U b) {
+        constexpr U ones = static_cast<U>(~U(0)) / 0xFF;
+        constexpr U low = ones * 0x7F;
+        constexpr U high = ones * 0x80;
+        return static_cast<U>(static_cast<U>((a & low) + (b & low)) ^ ((a ^ b) & high));
+    }
     
-public:
-    void clear() {
-        std::lock_guard<std::mutex> lock(mutex);
-        cache.clear();
+    // XOR с key ^ (i * 0x9E), ROL на key % разрядность, прибавление key + i
+    // к байту i - то же, что xor/rol/addObfuscate по байтам, но во всём
+    // слове сразу и без ветвлений; сдвиг на 0 определён
+    template<typename U>
+    static constexpr U transformWord(U value, Byte key) {
+        static_assert(std::is_unsigned_v<U>, "transformWord expects an unsigned word");
+        constexpr unsigned bits = sizeof(U) * 8;
+        constexpr U ones = static_cast<U>(~U(0)) / 0xFF;
+        U keys = static_cast<U>(ones * key);
+        
+        value ^= static_cast<U>(keys ^ byteRamp<U>(0x9E));
+        unsigned shift = key % bits;
+        value = static_cast<U>(static_cast<U>(value << shift) | static_cast<U>(value >> ((bits - shift) % bits)));
+        return addBytes(value, addBytes(keys, byteRamp<U>(1)));
     }
     
-    bool get(const Key& key, Value& value, Byte& storedKey) {
-        std::lock_guard<std::mutex> lock(mutex);
-        auto it = cache.find(key);
-        if (it != cache.end()) {
-            auto now = std::chrono::steady_clock::now();
-            if (now - it->second.timestamp < cacheDuration) {
-                value = it->second.data;
-                storedKey = it->second.key;
-                return true;
-            }
-            cache.erase(it);
+    // Целые числа и числа с плавающей точкой (через битовое представление).
+    // Без кэша и выделений памяти; при ключе, известном на этапе
+    // компиляции, вычисляется компилятором (float/double - при
+    // FEELMEHAPPY_BIT_CAST_CONSTEXPR)
+    template<typename T>
+    static constexpr T obfuscateScalar(T value, Byte key) {
+        static_assert(std::is_arithmetic_v<T>, "obfuscateScalar expects an arithmetic type");
+        if constexpr (std::is_same_v<T, bool>) {
+            return static_cast<bool>(transformWord(static_cast<Byte>(value), key));
+        } else if constexpr (std::is_integral_v<T>) {
+            using U = std::make_unsigned_t<T>;
+            return static_cast<T>(transformWord(static_cast<U>(value), key));
+        } else if constexpr (sizeof(T) == sizeof(DWord)) {
+            return bitCast<T>(transformWord(bitCast<DWord>(value), key));
+        } else if constexpr (sizeof(T) == sizeof(QWord)) {
+            return bitCast<T>(transformWord(bitCast<QWord>(value), key));
+        } else {
+            // long double: словами по 8, 4, 2 и 1 байт
+            Byte bytes[sizeof(T)];
+            std::memcpy(bytes, &value, sizeof(T));
+            transformWords(bytes, sizeof(T), key);
+            std::memcpy(&value, bytes, sizeof(T));
+            return value;
         }
-        return false;
     }
     
-    void put(const Key& key, const Value& value, Byte obfKey) {
-        std::lock_guard<std::mutex> lock(mutex);
-        CacheEntry entry{value, std::chrono::steady_clock::now(), obfKey};
-        cache[key] = entry;
+    // Нулевой указатель остаётся нулевым
+    template<typename T>
+    static T* obfuscateScalar(T* pointer, Byte key) {
+        if (!pointer) return nullptr;
+        return reinterpret_cast<T*>(transformWord(reinterpret_cast<uintptr_t>(pointer), key));
+    }
+    
+    static void transformWords(Byte* bytes, Size size, Byte key) {
+        Size i = 0;
+        auto step = [&](auto word) {
+            for (; i + sizeof(word) <= size; i += sizeof(word)) {
+                std::memcpy(&word, bytes + i, sizeof(word));
+                word = transformWord(word, key);
+                std::memcpy(bytes + i, &word, sizeof(word));
+            }
+        };
+        step(QWord(0));
+        step(DWord(0));
+        step(Word(0));
+        step(Byte(0));
+    }
+    
+    // Комбинированная обфускация для строк:
+    // XOR с key ^ (i * 0x37), прибавление i % 0xFF, затем сдвиги на 3.
+    // Маска и слагаемое зависят только от позиции, поэтому векторные ядра
+    // ведут их счётчиками в регистрах и дают побайтно тот же результат.
+    enum class Kernel { Scalar, SSE2, AVX2, AVX512, NEON };
+    
+    static bool kernelSupported(Kernel kernel) {
+        switch (kernel) {
+            case Kernel::Scalar: return true;
+            case Kernel::SSE2: return CpuFeatures::hasSSE2();
+            case Kernel::AVX2: return CpuFeatures::hasAVX2();
+            case Kernel::AVX512: return CpuFeatures::hasAVX512();
+            case Kernel::NEON: return CpuFeatures::hasNEON();
+        }
+        return false;
+    }
+    
+    // Лучшее доступное ядро, выбирается один раз
+    static Kernel activeKernel() {
+        static const Kernel kernel = kernelSupported(Kernel::AVX512) ? Kernel::AVX512 :
+                                     kernelSupported(Kernel::AVX2) ? Kernel::AVX2 :
+                                     kernelSupported(Kernel::SSE2) ? Kernel::SSE2 :
+                                     kernelSupported(Kernel::NEON) ? Kernel::NEON : Kernel::Scalar;
+        return kernel;
+    }
+    
+    // base - позиция data[0] во всём потоке: кусок, обработанный с его
+    // смещением, совпадает с соответствующей частью результата целиком
+    static void obfuscateInPlace(char* data, Size size, Byte key, Size base = 0) {
+        obfuscateWith(activeKernel(), data, size, key, base);
+    }
+    
+    static void obfuscateInPlace(wchar_t* data, Size size, Byte key, Size base = 0) {
+        obfuscateWith(activeKernel(), data, size, key, base);
+    }
+    
+    static void obfuscateWith(Kernel kernel, char* data, Size size, Byte key, Size base = 0) {
+        Size done = 0;
+        switch (kernel) {
+#ifdef FEELMEHAPPY_SSE2
+            case Kernel::SSE2: done = transformSSE2(data, size, key, base); break;
+#endif
+#ifdef FEELMEHAPPY_AVX2
+            case Kernel::AVX2: done = transformAVX2(data, size, key, base); break;
+#endif
+#ifdef FEELMEHAPPY_AVX512
+            case Kernel::AVX512: done = transformAVX512(data, size, key, base); break;
+#endif
+#ifdef FEELMEHAPPY_NEON
+            case Kernel::NEON: done = transformNEON(data, size, key, base); break;
+#endif
+            default: break;
+        }
+        transformScalar(data, done, size, key, base);
+    }
+    
+    // Векторные ядра для wchar_t написаны под 32-битный wchar_t,
+    // 16-битный (Windows) обрабатывается скалярно
+    static void obfuscateWith(Kernel kernel, wchar_t* data, Size size, Byte key, Size base = 0) {
+        Size done = 0;
+        if (sizeof(wchar_t) == sizeof(DWord)) {
+            switch (kernel) {
+#ifdef FEELMEHAPPY_SSE2
+                case Kernel::SSE2: done = transformWideSSE2(data, size, key, base); break;
+#endif
+#ifdef FEELMEHAPPY_AVX2
+                case Kernel::AVX2: done = transformWideAVX2(data, size, key, base); break;
+#endif
+#ifdef FEELMEHAPPY_AVX512
+                case Kernel::AVX512: done = transformWideAVX512(data, size, key, base); break;
+#endif
+#ifdef FEELMEHAPPY_NEON
+                case Kernel::NEON: done = transformWideNEON(data, size, key, base); break;
+#endif
+                default: break;
+            }
+        }
+        transformScalar(data, done, size, key, base);
+    }
+    
+    static std::string obfuscateString(const std::string& str, Byte key) {
+        std::string result = str;
+        obfuscateInPlace(&result[0], result.size(), key);
+        return result;
+    }
+
+    static std::wstring obfuscateWString(const std::wstring& str, Byte key) {
+        std::wstring result = str;
+        obfuscateInPlace(&result[0], result.size(), key);
+        return result;
+    }
+    
+    // ==== Массивы чисел ====
+    
+    // Числа шириной 1, 2, 4 и 8 байт идут через векторные ядра; bool и
+    // long double - поэлементно
+    template<typename T>
+    static constexpr bool kVectorElement = std::is_arithmetic_v<T> && !std::is_same_v<T, bool> &&
+        (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+    
+    // Поэлементно то же, что obfuscateScalar. Маска XOR и слагаемое
+    // повторяются с периодом в элемент, поворот - сдвиги в дорожках
+    // ширины элемента, поэтому ядра работают с сырыми байтами массива.
+    template<typename T>
+    static void obfuscateElements(T* data, Size count, Byte key) {
+        obfuscateElementsWith(activeKernel(), data, count, key);
+    }
+    
+    template<typename T>
+    static void obfuscateElementsWith(Kernel kernel, T* data, Size count, Byte key) {
+        static_assert(std::is_arithmetic_v<T>, "obfuscateElements expects an arithmetic type");
+        Size done = 0;
+        if constexpr (kVectorElement<T>) {
+            Byte* bytes = reinterpret_cast<Byte*>(data);
+            Size size = count * sizeof(T);
+            switch (kernel) {
+#ifdef FEELMEHAPPY_SSE2
+                case Kernel::SSE2: done = transformWordsSSE2<sizeof(T)>(bytes, size, key) / sizeof(T); break;
+#endif
+#ifdef FEELMEHAPPY_AVX2
+                case Kernel::AVX2: done = transformWordsAVX2<sizeof(T)>(bytes, size, key) / sizeof(T); break;
+#endif
+#ifdef FEELMEHAPPY_AVX512
+                case Kernel::AVX512: done = transformWordsAVX512<sizeof(T)>(bytes, size, key) / sizeof(T); break;
+#endif
+#ifdef FEELMEHAPPY_NEON
+                case Kernel::NEON: done = transformWordsNEON<sizeof(T)>(bytes, size, key) / sizeof(T); break;
+#endif
+                default: break;
+            }
+        }
+        for (Size i = done; i < count; ++i) {
+            data[i] = obfuscateScalar(data[i], key);
+        }
+    }
+    
+private:
+    // Эталонный скалярный путь, обрабатывает позиции [begin, size);
+    // позиция в потоке, от которой зависят счётчики, - base + i.
+    // Сдвиг знакового char/wchar_t арифметический, поэтому результат
+    // зависит от знаковости типа; векторные ядра повторяют это поведение.
+    static void transformScalar(char* data, Size begin, Size size, Byte key, Size base) {
+        for (Size i = begin; i < size; ++i) {
+            Size position = base + i;
+            data[i] ^= key ^ (position * 0x37);
+            data[i] += (position % 0xFF);
+            data[i] = (data[i] << 3) | (data[i] >> 5);
+        }
+    }
+    
+    static void transformScalar(wchar_t* data, Size begin, Size size, Byte key, Size base) {
+        for (Size i = begin; i < size; ++i) {
+            Size position = base + i;
+            data[i] ^= key ^ (position * 0x37);
+            data[i] += (position % 0xFFFF);
+            data[i] = (data[i] << 3) | (data[i] >> 13);
+        }
+    }
+    
+    static constexpr bool kSignedChar = std::is_signed<char>::value;
+    static constexpr bool kSignedWide = std::is_signed<wchar_t>::value;
+    
+    // Начальные значения счётчиков для первых Lanes позиций
+    template<typename T, Size Lanes>
+    struct alignas(64) LaneSeed {
+        struct Deferred {};
+        
+        T mask[Lanes];
+        T offset[Lanes];
+        
+        constexpr LaneSeed() : mask(), offset() {
+            for (Size j = 0; j < Lanes; ++j) {
+                mask[j] = static_cast<T>(j * 0x37);
+                offset[j] = static_cast<T>(j);
+            }
+        }
+        
+        // Без заполнения, для at()
+        explicit LaneSeed(Deferred) {}
+        
+        // Счётчики для позиций base..base+Lanes-1: при base == 0 готовая
+        // таблица, иначе она заполняется в storage
+        static const LaneSeed& at(Size base, LaneSeed& storage) {
+            static constexpr LaneSeed origin;
+            if (base == 0) return origin;
+            constexpr Size modulus = sizeof(T) == 1 ? 0xFF : 0xFFFF;
+            for (Size j = 0; j < Lanes; ++j) {
+                storage.mask[j] = static_cast<T>((base + j) * 0x37);
+                storage.offset[j] = static_cast<T>((base + j) % modulus);
+            }
+            return storage;
+        }
+    };
+    
+    // Все ядра возвращают число обработанных позиций, хвост доделывает
+    // transformScalar. Счётчики: mask = i * 0x37, offset = i % 0xFF
+    // (i % 0xFFFF для wchar_t); при переполнении offset вычитается модуль,
+    // для байтов это то же, что прибавить единицу.
+#ifdef FEELMEHAPPY_SSE2
+    static Size transformSSE2(char* data, Size size, Byte key, Size base) {
+        LaneSeed<Byte, 16> shifted{LaneSeed<Byte, 16>::Deferred{}};
+        const LaneSeed<Byte, 16>& seed = LaneSeed<Byte, 16>::at(base, shifted);
+        const __m128i keyV = _mm_set1_epi8(static_cast<char>(key));
+        const __m128i maskStep = _mm_set1_epi8(static_cast<char>(16 * 0x37));
+        const __m128i offsetStep = _mm_set1_epi8(16);
+        const __m128i offsetLimit = _mm_set1_epi8(static_cast<char>(0xFF - 16));
+        const __m128i one = _mm_set1_epi8(1);
+        const __m128i high = _mm_set1_epi8(static_cast<char>(0xF8));
+        const __m128i low = _mm_set1_epi8(0x07);
+        __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i*>(seed.mask));
+        __m128i offset = _mm_load_si128(reinterpret_cast<const __m128i*>(seed.offset));
+        
+        Size i = 0;
+        for (; i + 16 <= size; i += 16) {
+            __m128i* ptr = reinterpret_cast<__m128i*>(data + i);
+            __m128i v = _mm_xor_si128(_mm_loadu_si128(ptr), _mm_xor_si128(keyV, mask));
+            v = _mm_add_epi8(v, offset);
+            __m128i r = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(v, 3), high),
+                                     _mm_and_si128(_mm_srli_epi16(v, 5), low));
+            if (kSignedChar) {
+                r = _mm_or_si128(r, _mm_and_si128(_mm_cmplt_epi8(v, _mm_setzero_si128()), high));
+            }
+            _mm_storeu_si128(ptr, r);
+            
+            mask = _mm_add_epi8(mask, maskStep);
+            __m128i wrap = _mm_cmpeq_epi8(_mm_max_epu8(offset, offsetLimit), offset);
+            offset = _mm_add_epi8(_mm_add_epi8(offset, offsetStep), _mm_and_si128(wrap, one));
+        }
+        return i;
+    }
+    
+    static Size transformWideSSE2(wchar_t* data, Size size, Byte key, Size base) {
+        LaneSeed<DWord, 4> shifted{LaneSeed<DWord, 4>::Deferred{}};
+        const LaneSeed<DWord, 4>& seed = LaneSeed<DWord, 4>::at(base, shifted);
+        const __m128i keyV = _mm_set1_epi32(key);
+        const __m128i maskStep = _mm_set1_epi32(4 * 0x37);
+        const __m128i offsetStep = _mm_set1_epi32(4);
+        const __m128i offsetLimit = _mm_set1_epi32(0xFFFF - 4 - 1);
+        const __m128i modulus = _mm_set1_epi32(0xFFFF);
+        __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i*>(seed.mask));
+        __m128i offset = _mm_load_si128(reinterpret_cast<const __m128i*>(seed.offset));
+        
+        Size i = 0;
+        for (; i + 4 <= size; i += 4) {
+            __m128i* ptr = reinterpret_cast<__m128i*>(data + i);
+            __m128i v = _mm_xor_si128(_mm_loadu_si128(ptr), _mm_xor_si128(keyV, mask));
+            v = _mm_add_epi32(v, offset);
+            __m128i shifted = kSignedWide ? _mm_srai_epi32(v, 13) : _mm_srli_epi32(v, 13);
+            _mm_storeu_si128(ptr, _mm_or_si128(_mm_slli_epi32(v, 3), shifted));
+            
+            mask = _mm_add_epi32(mask, maskStep);
+            __m128i wrap = _mm_cmpgt_epi32(offset, offsetLimit);
+            offset = _mm_sub_epi32(_mm_add_epi32(offset, offsetStep), _mm_and_si128(wrap, modulus));
+        }
+        return i;
+    }
+#endif
+
+#ifdef FEELMEHAPPY_AVX2
+    FEELMEHAPPY_TARGET_AVX2
+    static Size transformAVX2(char* data, Size size, Byte key, Size base) {
+        LaneSeed<Byte, 32> shifted{LaneSeed<Byte, 32>::Deferred{}};
+        const LaneSeed<Byte, 32>& seed = LaneSeed<Byte, 32>::at(base, shifted);
+        const __m256i keyV = _mm256_set1_epi8(static_cast<char>(key));
+        const __m256i maskStep = _mm256_set1_epi8(static_cast<char>(32 * 0x37));
+        const __m256i offsetStep = _mm256_set1_epi8(32);
+        const __m256i offsetLimit = _mm256_set1_epi8(static_cast<char>(0xFF - 32));
+        const __m256i one = _mm256_set1_epi8(1);
+        const __m256i high = _mm256_set1_epi8(static_cast<char>(0xF8));
+        const __m256i low = _mm256_set1_epi8(0x07);
+        __m256i mask = _mm256_load_si256(reinterpret_cast<const __m256i*>(seed.mask));
+        __m256i offset = _mm256_load_si256(reinterpret_cast<const __m256i*>(seed.offset));
+        
+        Size i = 0;
+        for (; i + 32 <= size; i += 32) {
+            __m256i* ptr = reinterpret_cast<__m256i*>(data + i);
+            __m256i v = _mm256_xor_si256(_mm256_loadu_si256(ptr), _mm256_xor_si256(keyV, mask));
+            v = _mm256_add_epi8(v, offset);
+            __m256i r = _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi16(v, 3), high),
+                                        _mm256_and_si256(_mm256_srli_epi16(v, 5), low));
+            if (kSignedChar) {
+                r = _mm256_or_si256(r, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_setzero_si256(), v), high));
+            }
+            _mm256_storeu_si256(ptr, r);
+            
+            mask = _mm256_add_epi8(mask, maskStep);
+            __m256i wrap = _mm256_cmpeq_epi8(_mm256_max_epu8(offset, offsetLimit), offset);
+            offset = _mm256_add_epi8(_mm256_add_epi8(offset, offsetStep), _mm256_and_si256(wrap, one));
+        }
+        return i;
+    }
+    
+    FEELMEHAPPY_TARGET_AVX2
+    static Size transformWideAVX2(wchar_t* data, Size size, Byte key, Size base) {
+        LaneSeed<DWord, 8> shifted{LaneSeed<DWord, 8>::Deferred{}};
+        const LaneSeed<DWord, 8>& seed = LaneSeed<DWord, 8>::at(base, shifted);
+        const __m256i keyV = _mm256_set1_epi32(key);
+        const __m256i maskStep = _mm256_set1_epi32(8 * 0x37);
+        const __m256i offsetStep = _mm256_set1_epi32(8);
+        const __m256i offsetLimit = _mm256_set1_epi32(0xFFFF - 8 - 1);
+        const __m256i modulus = _mm256_set1_epi32(0xFFFF);
+        __m256i mask = _mm256_load_si256(reinterpret_cast<const __m256i*>(seed.mask));
+        __m256i offset = _mm256_load_si256(reinterpret_cast<const __m256i*>(seed.offset));
+        
+        Size i = 0;
+        for (; i + 8 <= size; i += 8) {
+            __m256i* ptr = reinterpret_cast<__m256i*>(data + i);
+            __m256i v = _mm256_xor_si256(_mm256_loadu_si256(ptr), _mm256_xor_si256(keyV, mask));
+            v = _mm256_add_epi32(v, offset);
+            __m256i shifted = kSignedWide ? _mm256_srai_epi32(v, 13) : _mm256_srli_epi32(v, 13);
+            _mm256_storeu_si256(ptr, _mm256_or_si256(_mm256_slli_epi32(v, 3), shifted));
+            
+            mask = _mm256_add_epi32(mask, maskStep);
+            __m256i wrap = _mm256_cmpgt_epi32(offset, offsetLimit);
+            offset = _mm256_sub_epi32(_mm256_add_epi32(offset, offsetStep), _mm256_and_si256(wrap, modulus));
+        }
+        return i;
+    }
+#endif
+
+#ifdef FEELMEHAPPY_AVX512
+    FEELMEHAPPY_TARGET_AVX512
+    static Size transformAVX512(char* data, Size size, Byte key, Size base) {
+        LaneSeed<Byte, 64> shifted{LaneSeed<Byte, 64>::Deferred{}};
+        const LaneSeed<Byte, 64>& seed = LaneSeed<Byte, 64>::at(base, shifted);
+        const __m512i keyV = _mm512_set1_epi8(static_cast<char>(key));
+        const __m512i maskStep = _mm512_set1_epi8(static_cast<char>(64 * 0x37));
+        const __m512i offsetStep = _mm512_set1_epi8(64);
+        const __m512i offsetLimit = _mm512_set1_epi8(static_cast<char>(0xFF - 64));
+        const __m512i one = _mm512_set1_epi8(1);
+        const __m512i high = _mm512_set1_epi8(static_cast<char>(0xF8));
+        const __m512i low = _mm512_set1_epi8(0x07);
+        __m512i mask = _mm512_load_si512(seed.mask);
+        __m512i offset = _mm512_load_si512(seed.offset);
+        
+        Size i = 0;
+        for (; i + 64 <= size; i += 64) {
+            char* ptr = data + i;
+            __m512i v = _mm512_xor_si512(_mm512_loadu_si512(ptr), _mm512_xor_si512(keyV, mask));
+            v = _mm512_add_epi8(v, offset);
+            __m512i r = _mm512_or_si512(_mm512_and_si512(_mm512_slli_epi16(v, 3), high),
+                                        _mm512_and_si512(_mm512_srli_epi16(v, 5), low));
+            if (kSignedChar) {
+                r = _mm512_or_si512(r, _mm512_maskz_mov_epi8(_mm512_movepi8_mask(v), high));
+            }
+            _mm512_storeu_si512(ptr, r);
+            
+            mask = _mm512_add_epi8(mask, maskStep);
+            __mmask64 wrap = _mm512_cmpge_epu8_mask(offset, offsetLimit);
+            offset = _mm512_add_epi8(offset, offsetStep);
+            offset = _mm512_mask_add_epi8(offset, wrap, offset, one);
+        }
+        return i;
+    }
+    
+    FEELMEHAPPY_TARGET_AVX512
+    static Size transformWideAVX512(wchar_t* data, Size size, Byte key, Size base) {
+        LaneSeed<DWord, 16> shifted{LaneSeed<DWord, 16>::Deferred{}};
+        const LaneSeed<DWord, 16>& seed = LaneSeed<DWord, 16>::at(base, shifted);
+        const __m512i keyV = _mm512_set1_epi32(key);
+        const __m512i maskStep = _mm512_set1_epi32(16 * 0x37);
+        const __m512i offsetStep = _mm512_set1_epi32(16);
+        const __m512i offsetLimit = _mm512_set1_epi32(0xFFFF - 16);
+        const __m512i modulus = _mm512_set1_epi32(0xFFFF);
+        // maskz-формы сдвигов: немаскированные дают у GCC ложное -Wmaybe-uninitialized
+        const __mmask16 all = 0xFFFF;
+        __m512i mask = _mm512_load_si512(seed.mask);
+        __m512i offset = _mm512_load_si512(seed.offset);
+        
+        Size i = 0;
+        for (; i + 16 <= size; i += 16) {
+            wchar_t* ptr = data + i;
+            __m512i v = _mm512_xor_si512(_mm512_loadu_si512(ptr), _mm512_xor_si512(keyV, mask));
+            v = _mm512_add_epi32(v, offset);
+            __m512i shifted = kSignedWide ? _mm512_maskz_srai_epi32(all, v, 13) : _mm512_maskz_srli_epi32(all, v, 13);
+            _mm512_storeu_si512(ptr, _mm512_or_si512(_mm512_maskz_slli_epi32(all, v, 3), shifted));
+            
+            mask = _mm512_add_epi32(mask, maskStep);
+            __mmask16 wrap = _mm512_cmpge_epi32_mask(offset, offsetLimit);
+            offset = _mm512_add_epi32(offset, offsetStep);
+            offset = _mm512_mask_sub_epi32(offset, wrap, offset, modulus);
+        }
+        return i;
+    }
+#endif
+
+#ifdef FEELMEHAPPY_NEON
+    static Size transformNEON(char* data, Size size, Byte key, Size base) {
+        LaneSeed<Byte, 16> shifted{LaneSeed<Byte, 16>::Deferred{}};
+        const LaneSeed<Byte, 16>& seed = LaneSeed<Byte, 16>::at(base, shifted);
+        const uint8x16_t keyV = vdupq_n_u8(key);
+        const uint8x16_t maskStep = vdupq_n_u8(static_cast<Byte>(16 * 0x37));
+        const uint8x16_t offsetStep = vdupq_n_u8(16);
+        const uint8x16_t offsetLimit = vdupq_n_u8(0xFF - 16);
+        const uint8x16_t one = vdupq_n_u8(1);
+        const uint8x16_t high = vdupq_n_u8(0xF8);
+        uint8x16_t mask = vld1q_u8(seed.mask);
+        uint8x16_t offset = vld1q_u8(seed.offset);
+        
+        Size i = 0;
+        for (; i + 16 <= size; i += 16) {
+            Byte* ptr = reinterpret_cast<Byte*>(data + i);
+            uint8x16_t v = veorq_u8(vld1q_u8(ptr), veorq_u8(keyV, mask));
+            v = vaddq_u8(v, offset);
+            uint8x16_t r = vorrq_u8(vshlq_n_u8(v, 3), vshrq_n_u8(v, 5));
+            if (kSignedChar) {
+                r = vorrq_u8(r, vandq_u8(vcltq_s8(vreinterpretq_s8_u8(v), vdupq_n_s8(0)), high));
+            }
+            vst1q_u8(ptr, r);
+            
+            mask = vaddq_u8(mask, maskStep);
+            uint8x16_t wrap = vcgeq_u8(offset, offsetLimit);
+            offset = vaddq_u8(vaddq_u8(offset, offsetStep), vandq_u8(wrap, one));
+        }
+        return i;
+    }
+    
+    static Size transformWideNEON(wchar_t* data, Size size, Byte key, Size base) {
+        LaneSeed<DWord, 4> shifted{LaneSeed<DWord, 4>::Deferred{}};
+        const LaneSeed<DWord, 4>& seed = LaneSeed<DWord, 4>::at(base, shifted);
+        const uint32x4_t keyV = vdupq_n_u32(key);
+        const uint32x4_t maskStep = vdupq_n_u32(4 * 0x37);
+        const uint32x4_t offsetStep = vdupq_n_u32(4);
+        const uint32x4_t offsetLimit = vdupq_n_u32(0xFFFF - 4);
+        const uint32x4_t modulus = vdupq_n_u32(0xFFFF);
+        uint32x4_t mask = vld1q_u32(seed.mask);
+        uint32x4_t offset = vld1q_u32(seed.offset);
+        
+        Size i = 0;
+        for (; i + 4 <= size; i += 4) {
+            DWord* ptr = reinterpret_cast<DWord*>(data + i);
+            uint32x4_t v = veorq_u32(vld1q_u32(ptr), veorq_u32(keyV, mask));
+            v = vaddq_u32(v, offset);
+            uint32x4_t shifted = kSignedWide
+                ? vreinterpretq_u32_s32(vshrq_n_s32(vreinterpretq_s32_u32(v), 13))
+                : vshrq_n_u32(v, 13);
+            vst1q_u32(ptr, vorrq_u32(vshlq_n_u32(v, 3), shifted));
+            
+            mask = vaddq_u32(mask, maskStep);
+            uint32x4_t wrap = vcgeq_u32(offset, offsetLimit);
+            offset = vsubq_u32(vaddq_u32(offset, offsetStep), vandq_u32(wrap, modulus));
+        }
+        return i;
+    }
+#endif
+    
+    // Маска XOR и слагаемое transformWord для элемента ширины Width,
+    // повторённые на 8 байт
+    template<Size Width>
+    static std::pair<QWord, QWord> wordPatterns(Byte key) {
+        using U = std::conditional_t<Width == 1, Byte, std::conditional_t<Width == 2, Word,
+                  std::conditional_t<Width == 4, DWord, QWord>>>;
+        constexpr U ones = static_cast<U>(~U(0)) / 0xFF;
+        U keys = static_cast<U>(ones * key);
+        U mask = static_cast<U>(keys ^ byteRamp<U>(0x9E));
+        U addend = addBytes(keys, byteRamp<U>(1));
+        QWord maskWord = 0;
+        QWord addendWord = 0;
+        for (Size i = 0; i < sizeof(QWord); i += Width) {
+            maskWord |= static_cast<QWord>(mask) << (8 * i);
+            addendWord |= static_cast<QWord>(addend) << (8 * i);
+        }
+        return {maskWord, addendWord};
+    }
+    
+    // Ядра для массивов возвращают число обработанных байт (кратно 16, 32
+    // или 64), остальные элементы доделывает obfuscateScalar. Сдвиг на
+    // ширину дорожки даёт ноль, поэтому поворот на 0 не требует ветвления.
+    // Байтовых сдвигов в SSE/AVX нет: байты сдвигаются в 16-битных дорожках
+    // и обрезаются масками.
+#ifdef FEELMEHAPPY_SSE2
+    template<Size Width>
+    static Size transformWordsSSE2(Byte* data, Size size, Byte key) {
+        auto patterns = wordPatterns<Width>(key);
+        const unsigned bits = Width * 8;
+        const unsigned shift = key % bits;
+        const __m128i mask = _mm_set1_epi64x(static_cast<long long>(patterns.first));
+        const __m128i addend = _mm_set1_epi64x(static_cast<long long>(patterns.second));
+        const __m128i left = _mm_cvtsi32_si128(static_cast<int>(shift));
+        const __m128i right = _mm_cvtsi32_si128(static_cast<int>(bits - shift));
+        const __m128i keepLeft = _mm_set1_epi8(static_cast<char>(0xFF << (shift % 8)));
+        const __m128i keepRight = _mm_set1_epi8(static_cast<char>(0xFF >> (8 - shift % 8)));
+        
+        Size i = 0;
+        for (; i + 16 <= size; i += 16) {
+            __m128i* ptr = reinterpret_cast<__m128i*>(data + i);
+            __m128i v = _mm_xor_si128(_mm_loadu_si128(ptr), mask);
+            if constexpr (Width == 1) {
+                v = _mm_or_si128(_mm_and_si128(_mm_sll_epi16(v, left), keepLeft),
+                                 _mm_and_si128(_mm_srl_epi16(v, right), keepRight));
+            } else if constexpr (Width == 2) {
+                v = _mm_or_si128(_mm_sll_epi16(v, left), _mm_srl_epi16(v, right));
+            } else if constexpr (Width == 4) {
+                v = _mm_or_si128(_mm_sll_epi32(v, left), _mm_srl_epi32(v, right));
+            } else {
+                v = _mm_or_si128(_mm_sll_epi64(v, left), _mm_srl_epi64(v, right));
+            }
+            _mm_storeu_si128(ptr, _mm_add_epi8(v, addend));
+        }
+        return i;
+    }
+#endif
+
+#ifdef FEELMEHAPPY_AVX2
+    template<Size Width>
+    FEELMEHAPPY_TARGET_AVX2
+    static Size transformWordsAVX2(Byte* data, Size size, Byte key) {
+        auto patterns = wordPatterns<Width>(key);
+        const unsigned bits = Width * 8;
+        const unsigned shift = key % bits;
+        const __m256i mask = _mm256_set1_epi64x(static_cast<long long>(patterns.first));
+        const __m256i addend = _mm256_set1_epi64x(static_cast<long long>(patterns.second));
+        const __m128i left = _mm_cvtsi32_si128(static_cast<int>(shift));
+        const __m128i right = _mm_cvtsi32_si128(static_cast<int>(bits - shift));
+        const __m256i keepLeft = _mm256_set1_epi8(static_cast<char>(0xFF << (shift % 8)));
+        const __m256i keepRight = _mm256_set1_epi8(static_cast<char>(0xFF >> (8 - shift % 8)));
+        
+        Size i = 0;
+        for (; i + 32 <= size; i += 32) {
+            __m256i* ptr = reinterpret_cast<__m256i*>(data + i);
+            __m256i v = _mm256_xor_si256(_mm256_loadu_si256(ptr), mask);
+            if constexpr (Width == 1) {
+                v = _mm256_or_si256(_mm256_and_si256(_mm256_sll_epi16(v, left), keepLeft),
+                                    _mm256_and_si256(_mm256_srl_epi16(v, right), keepRight));
+            } else if constexpr (Width == 2) {
+                v = _mm256_or_si256(_mm256_sll_epi16(v, left), _mm256_srl_epi16(v, right));
+            } else if constexpr (Width == 4) {
+                v = _mm256_or_si256(_mm256_sll_epi32(v, left), _mm256_srl_epi32(v, right));
+            } else {
+                v = _mm256_or_si256(_mm256_sll_epi64(v, left), _mm256_srl_epi64(v, right));
+            }
+            _mm256_storeu_si256(ptr, _mm256_add_epi8(v, addend));
+        }
+        return i;
+    }
+#endif
+
+#ifdef FEELMEHAPPY_AVX512
+    template<Size Width>
+    FEELMEHAPPY_TARGET_AVX512
+    static Size transformWordsAVX512(Byte* data, Size size, Byte key) {
+        auto patterns = wordPatterns<Width>(key);
+        const unsigned bits = Width * 8;
+        const unsigned shift = key % bits;
+        const __m512i mask = _mm512_set1_epi64(static_cast<long long>(patterns.first));
+        const __m512i addend = _mm512_set1_epi64(static_cast<long long>(patterns.second));
+        __m512i left;
+        __m512i right;
+        if constexpr (Width <= 2) {
+            left = _mm512_set1_epi16(static_cast<short>(shift));
+            right = _mm512_set1_epi16(static_cast<short>(bits - shift));
+        } else if constexpr (Width == 4) {
+            left = _mm512_set1_epi32(static_cast<int>(shift));
+            right = _mm512_set1_epi32(static_cast<int>(bits - shift));
+        } else {
+            left = _mm512_set1_epi64(shift);
+            right = _mm512_set1_epi64(bits - shift);
+        }
+        const __m512i keepLeft = _mm512_set1_epi8(static_cast<char>(0xFF << (shift % 8)));
+        const __m512i keepRight = _mm512_set1_epi8(static_cast<char>(0xFF >> (8 - shift % 8)));
+        
+        Size i = 0;
+        for (; i + 64 <= size; i += 64) {
+            void* ptr = data + i;
+            __m512i v = _mm512_xor_si512(_mm512_loadu_si512(ptr), mask);
+            if constexpr (Width == 1) {
+                v = _mm512_or_si512(_mm512_and_si512(_mm512_sllv_epi16(v, left), keepLeft),
+                                    _mm512_and_si512(_mm512_srlv_epi16(v, right), keepRight));
+            } else if constexpr (Width == 2) {
+                v = _mm512_or_si512(_mm512_sllv_epi16(v, left), _mm512_srlv_epi16(v, right));
+            } else if constexpr (Width == 4) {
+                // maskz-формы: без _mm512_undefined и ложного -Wmaybe-uninitialized в GCC 12
+                v = _mm512_or_si512(_mm512_maskz_sllv_epi32(0xFFFF, v, left), _mm512_maskz_srlv_epi32(0xFFFF, v, right));
+            } else {
+                v = _mm512_or_si512(_mm512_maskz_sllv_epi64(0xFF, v, left), _mm512_maskz_srlv_epi64(0xFF, v, right));
+            }
+            _mm512_storeu_si512(ptr, _mm512_add_epi8(v, addend));
+        }
+        return i;
+    }
+#endif
+
+#ifdef FEELMEHAPPY_NEON
+    // Сдвиг NEON на отрицательное число - сдвиг вправо; на ширину дорожки
+    // и больше даёт ноль
+    template<Size Width>
+    static Size transformWordsNEON(Byte* data, Size size, Byte key) {
+        auto patterns = wordPatterns<Width>(key);
+        const int bits = Width * 8;
+        const int shift = key % bits;
+        const uint8x16_t mask = vreinterpretq_u8_u64(vdupq_n_u64(patterns.first));
+        const uint8x16_t addend = vreinterpretq_u8_u64(vdupq_n_u64(patterns.second));
+        
+        Size i = 0;
+        for (; i + 16 <= size; i += 16) {
+            uint8x16_t v = veorq_u8(vld1q_u8(data + i), mask);
+            if constexpr (Width == 1) {
+                v = vorrq_u8(vshlq_u8(v, vdupq_n_s8(static_cast<int8_t>(shift))),
+                             vshlq_u8(v, vdupq_n_s8(static_cast<int8_t>(shift - bits))));
+            } else if constexpr (Width == 2) {
+                uint16x8_t w = vreinterpretq_u16_u8(v);
+                v = vreinterpretq_u8_u16(vorrq_u16(vshlq_u16(w, vdupq_n_s16(static_cast<int16_t>(shift))),
+                                                   vshlq_u16(w, vdupq_n_s16(static_cast<int16_t>(shift - bits)))));
+            } else if constexpr (Width == 4) {
+                uint32x4_t w = vreinterpretq_u32_u8(v);
+                v = vreinterpretq_u8_u32(vorrq_u32(vshlq_u32(w, vdupq_n_s32(shift)),
+                                                   vshlq_u32(w, vdupq_n_s32(shift - bits))));
+            } else {
+                uint64x2_t w = vreinterpretq_u64_u8(v);
+                v = vreinterpretq_u8_u64(vorrq_u64(vshlq_u64(w, vdupq_n_s64(shift)),
+                                                   vshlq_u64(w, vdupq_n_s64(shift - bits))));
+            }
+            vst1q_u8(data + i, vaddq_u8(v, addend));
+        }
+        return i;
+    }
+#endif
+};
+
+// Пул потоков для обработки больших буферов частями. Вызывающий поток
+// тоже берёт части, поэтому пул из N потоков даёт N + 1 исполнителей.
+// Одновременно выполняется одна задача; если пул занят, вызывающий
+// поток выполняет свою задачу сам.
+class WorkerPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::mutex runMutex;
+    std::condition_variable wakeup;
+    std::condition_variable finished;
+    const std::function<void(Size)>* task = nullptr;
+    Size taskCount = 0;
+    std::atomic<Size> nextTask{0};
+    Size active = 0;
+    QWord generation = 0;
+    bool stopping = false;
+    
+    void drain(const std::function<void(Size)>& job, Size count) {
+        for (Size t = nextTask.fetch_add(1); t < count; t = nextTask.fetch_add(1)) {
+            job(t);
+        }
+    }
+    
+    // Задача и число частей читаются под блокировкой вместе с увеличением
+    // active, поэтому parallelFor не вернётся, пока рабочий держит задачу
+    void run() {
+        QWord seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wakeup.wait(lock, [this, &seen]() { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            if (!task) continue;
+            
+            const std::function<void(Size)>& job = *task;
+            Size count = taskCount;
+            ++active;
+            lock.unlock();
+            drain(job, count);
+            lock.lock();
+            if (--active == 0) {
+                finished.notify_all();
+            }
+        }
+    }
+    
+public:
+    explicit WorkerPool(Size threads) {
+        for (Size i = 0; i < threads; ++i) {
+            workers.emplace_back([this]() { run(); });
+        }
+    }
+    
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeup.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+    
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    
+    // Общий пул, создаётся при первом обращении. По умолчанию потоков на
+    // один меньше, чем ядер: вызывающий поток - последний исполнитель.
+    static WorkerPool& shared() {
+        static WorkerPool pool(FEELMEHAPPY_WORKER_THREADS > 0 ? Size(FEELMEHAPPY_WORKER_THREADS) :
+                               std::max<Size>(std::thread::hardware_concurrency(), 1) - 1);
+        return pool;
+    }
+    
+    Size concurrency() const {
+        return workers.size() + 1;
+    }
+    
+    // Выполняет job(0) .. job(count - 1) и дожидается всех частей
+    void parallelFor(Size count, const std::function<void(Size)>& job) {
+        std::unique_lock<std::mutex> busy(runMutex, std::try_to_lock);
+        if (workers.empty() || count < 2 || !busy.owns_lock()) {
+            for (Size t = 0; t < count; ++t) {
+                job(t);
+            }
+            return;
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task = &job;
+            taskCount = count;
+            nextTask.store(0);
+            ++generation;
+        }
+        wakeup.notify_all();
+        drain(job, count);
+        
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this]() { return active == 0; });
+        task = nullptr;
+    }
+};
+
+// Потоковая обфускация больших данных. Вход подаётся кусками любого
+// размера, позиция в потоке переносится между ними, и результат совпадает
+// с ObfuscationAlgorithms::obfuscateString для склеенного входа, так что
+// в памяти достаточно держать один кусок. Куски от 2 * chunkSize байт
+// делятся на части по chunkSize и обрабатываются пулом параллельно.
+class StreamObfuscator {
+private:
+    Byte key;
+    Size chunkSize;
+    WorkerPool* pool;
+    Size offset = 0;
+    ObfuscationAlgorithms::Kernel kernel = ObfuscationAlgorithms::activeKernel();
+    std::vector<char> buffer;
+    
+    // Части обрабатываются независимо: преобразование зависит только от
+    // ключа и позиции байта в потоке
+    template<typename Part>
+    void forEachPart(Size size, Part&& part) {
+        if (pool && size >= 2 * chunkSize && pool->concurrency() > 1) {
+            Size parts = (size + chunkSize - 1) / chunkSize;
+            pool->parallelFor(parts, [this, size, &part](Size index) {
+                Size begin = index * chunkSize;
+                part(begin, std::min(chunkSize, size - begin));
+            });
+        } else {
+            part(Size(0), size);
+        }
+        offset += size;
+    }
+    
+public:
+    // pool = nullptr - без параллельной обработки
+    explicit StreamObfuscator(Byte streamKey, Size chunk = FEELMEHAPPY_STREAM_CHUNK,
+                              WorkerPool* workers = &WorkerPool::shared())
+        : key(streamKey), chunkSize(std::max<Size>(chunk, 1)), pool(workers) {}
+    
+    // Очередной кусок на месте
+    void update(char* data, Size size) {
+        Size base = offset;
+        forEachPart(size, [this, data, base](Size begin, Size length) {
+            ObfuscationAlgorithms::obfuscateWith(kernel, data + begin, length, key, base + begin);
+        });
+    }
+    
+    // Очередной кусок из input в output той же длины; буферы могут совпадать
+    void update(const char* input, Size size, char* output) {
+        Size base = offset;
+        forEachPart(size, [this, input, output, base](Size begin, Size length) {
+            std::memmove(output + begin, input + begin, length);
+            ObfuscationAlgorithms::obfuscateWith(kernel, output + begin, length, key, base + begin);
+        });
+    }
+    
+    // Пара итераторов, например istreambuf_iterator / ostreambuf_iterator:
+    // данные проходят через внутренний буфер размером в chunkSize
+    template<typename InputIt, typename OutputIt>
+    OutputIt update(InputIt first, InputIt last, OutputIt out) {
+        buffer.resize(chunkSize);
+        while (first != last) {
+            Size filled = 0;
+            for (; filled < chunkSize && first != last; ++first) {
+                buffer[filled++] = static_cast<char>(*first);
+            }
+            update(buffer.data(), filled);
+            out = std::copy(buffer.data(), buffer.data() + filled, out);
+        }
+        return out;
+    }
+    
+    // Сколько байт потока уже обработано
+    Size position() const {
+        return offset;
+    }
+    
+    // Продолжить с произвольной позиции, например после перезапуска
+    void seek(Size position) {
+        offset = position;
+    }
+};
+
+// Маска для Secret: поток splitmix64 от соли процесса и собственного
+// зерна значения. Соль хранится отдельно от значений, поэтому байты
+// Secret вместе с его зерном ещё не дают открытого текста.
+class SecretMask {
+private:
+    // Создаётся при первом использовании, а не при старте процесса
+    static QWord salt() {
+        static const QWord value = KeyGenerator::generateQWord();
+        return value;
+    }
+    
+    static QWord word(QWord seed, Size index) {
+        QWord z = seed + (index + 1) * 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    
+public:
+    // output = input ^ маска; буферы могут совпадать
+    static void apply(Byte* output, const Byte* input, Size size, QWord nonce) {
+        QWord seed = salt() ^ nonce;
+        Size i = 0;
+        for (; i + sizeof(QWord) <= size; i += sizeof(QWord)) {
+            QWord value;
+            std::memcpy(&value, input + i, sizeof(QWord));
+            value ^= word(seed, i / sizeof(QWord));
+            std::memcpy(output + i, &value, sizeof(QWord));
+        }
+        if (i < size) {
+            QWord mask = word(seed, i / sizeof(QWord));
+            for (Size j = 0; i + j < size; ++j) {
+                output[i + j] = input[i + j] ^ static_cast<Byte>(mask >> (8 * j));
+            }
+        }
+    }
+    
+    // Затирание через volatile: компилятор не удалит его как мёртвую запись
+    static void wipe(void* data, Size size) {
+        volatile Byte* bytes = static_cast<volatile Byte*>(data);
+        for (Size i = 0; i < size; ++i) {
+            bytes[i] = 0;
+        }
+    }
+};
+
+// Значение, которое в памяти хранится только замаскированным: байты лежат
+// в самом объекте, без кучи, кэшей и блокировок. Открытое значение
+// доступно только через Scope - копию на стеке, которая затирается при
+// выходе из области видимости. Только перемещение; перемещённый Secret
+// хранит T с нулевыми байтами.
+template<typename T>
+class Secret {
+    static_assert(std::is_trivially_copyable<T>::value && std::is_default_constructible<T>::value,
+                  "Secret<T> хранит байты значения: T должен быть тривиально копируемым");
+    
+private:
+    Byte masked[sizeof(T)];
+    QWord nonce;
+    
+    void mask(const void* plain) {
+        nonce = KeyGenerator::generateQWord();
+        SecretMask::apply(masked, static_cast<const Byte*>(plain), sizeof(T), nonce);
+    }
+    
+    void takeFrom(Secret& other) {
+        std::memcpy(masked, other.masked, sizeof(T));
+        nonce = other.nonce;
+        Byte zero[sizeof(T)] = {};
+        other.mask(zero);
+    }
+    
+public:
+    class Scope {
+    private:
+        T value;
+        
+        friend class Secret;
+        
+        explicit Scope(const Secret& secret) {
+            SecretMask::apply(reinterpret_cast<Byte*>(&value), secret.masked, sizeof(T), secret.nonce);
+        }
+        
+    public:
+        ~Scope() {
+            SecretMask::wipe(&value, sizeof(T));
+        }
+        
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        
+        const T& get() const {
+            return value;
+        }
+        
+        const T& operator*() const {
+            return value;
+        }
+        
+        const T* operator->() const {
+            return &value;
+        }
+    };
+    
+    explicit Secret(const T& value) {
+        mask(&value);
+    }
+    
+    Secret(Secret&& other) noexcept {
+        takeFrom(other);
+    }
+    
+    Secret& operator=(Secret&& other) noexcept {
+        if (this != &other) {
+            takeFrom(other);
+        }
+        return *this;
+    }
+    
+    Secret(const Secret&) = delete;
+    Secret& operator=(const Secret&) = delete;
+    
+    ~Secret() {
+        SecretMask::wipe(masked, sizeof(T));
+    }
+    
+    // Открытое значение до конца жизни возвращённого Scope
+    Scope reveal() const {
+        return Scope(*this);
+    }
+    
+    // Вызывает f с открытым значением и затирает его сразу после
+    template<typename F>
+    decltype(auto) use(F&& f) const {
+        Scope scope(*this);
+        return std::forward<F>(f)(scope.get());
+    }
+    
+    // Новое значение с новым зерном
+    void assign(const T& value) {
+        mask(&value);
+    }
+};
+
+// Secret для строкового литерала: символы вместе с завершающим нулём
+// хранятся в std::array, scope->data() даёт C-строку
+template<typename Char, Size N>
+Secret<std::array<Char, N>> makeSecret(const Char (&literal)[N]) {
+    std::array<Char, N> value;
+    std::copy(literal, literal + N, value.begin());
+    Secret<std::array<Char, N>> secret(value);
+    SecretMask::wipe(value.data(), sizeof(value));
+    return secret;
+}
+
+// Результат литерала на месте вызова FEEL (thread_local): действителен,
+// пока version совпадает с опубликованной версией ключа
+template<typename Char, Size N>
+struct LiteralSlot {
+    QWord version = ~QWord(0);
+    std::array<Char, N> buffer;
+};
+
+// Строковый литерал, зашифрованный на этапе компиляции
+template<typename Char, Size N>
+struct EncryptedLiteral {
+    using Slot = LiteralSlot<Char, N>;
+    
+    std::array<Char, N> data;
+    Size length;
+    Byte seed;
+    TypeDetector::DataType type;
+};
+
+// Текст литерала, восстановленный из исходного кода аргумента FEEL
+template<typename Char, Size N>
+struct LiteralText {
+    std::array<Char, N> data{};
+    bool valid = false;
+};
+
+// Признак константного массива символов: так FEEL получает литерал.
+// Именованный массив даёт тот же тип, поэтому литерал отличает уже
+// LiteralCipher::parse по тексту аргумента.
+// Tag делает проверку зависимой внутри обобщённой лямбды макроса FEEL.
+template<typename T, typename Tag>
+struct IsStringLiteral : std::false_type {};
+
+template<Size N, typename Tag>
+struct IsStringLiteral<const char (&)[N], Tag> : std::true_type {
+    using Char = char;
+    static constexpr Size size = N;
+};
+
+template<Size N, typename Tag>
+struct IsStringLiteral<const wchar_t (&)[N], Tag> : std::true_type {
+    using Char = wchar_t;
+    static constexpr Size size = N;
+};
+
+// Откладывает разрешение имени до инстанцирования лямбды FEEL,
+// чтобы отброшенная ветка if constexpr не проверялась заранее
+template<typename T, typename Tag>
+struct DependentType {
+    using type = T;
+};
+
+// Шифрование литералов на этапе компиляции
+class LiteralCipher {
+public:
+    // Зерно ключа для конкретного места вызова
+    static constexpr Byte seed(const char* file, unsigned line, unsigned counter) {
+        DWord hash = 0x811C9DC5u;
+        for (Size i = 0; file[i]; ++i) {
+            hash = (hash ^ static_cast<Byte>(file[i])) * 0x01000193u;
+        }
+        hash = (hash ^ line) * 0x01000193u;
+        hash = (hash ^ counter) * 0x01000193u;
+        return static_cast<Byte>((hash >> 24) ^ (hash >> 8) ^ hash);
+    }
+
+    template<typename Tag, typename Char, Size N>
+    static constexpr EncryptedLiteral<Char, N> encrypt(const Char (&str)[N], Byte seed) {
+        EncryptedLiteral<Char, N> result{};
+        result.seed = seed;
+        result.length = 0;
+        while (result.length < N && str[result.length]) ++result.length;
+
+        if constexpr (std::is_same_v<Char, char>) {
+            result.type = TypeDetector::classify(str, result.length);
+        } else {
+            result.type = TypeDetector::DataType::WideString;
+        }
+
+        for (Size i = 0; i < N; ++i) {
+            result.data[i] = static_cast<Char>(str[i] ^ keystream<Char>(seed, i));
+        }
+        return result;
+    }
+
+    template<typename Char, Size N>
+    static constexpr EncryptedLiteral<Char, N> encrypt(const LiteralText<Char, N>& text, Byte seed) {
+        Char str[N] = {};
+        for (Size i = 0; i < N; ++i) {
+            str[i] = text.data[i];
+        }
+        return encrypt<void>(str, seed);
+    }
+
+    // Разбор исходного текста аргумента FEEL (#__VA_ARGS__). Действителен,
+    // только если аргумент - один или несколько соседних литералов
+    // "..." (для wchar_t ещё L"...") и разобранная длина совпадает с N - 1.
+    // Литералы в скобках, префиксы u8 и R, универсальные имена символов и
+    // не-ASCII в широких литералах не разбираются: такие аргументы идут
+    // обычным путём obfuscate() с тем же результатом. Какое написание каким
+    // путём идёт, закреплено в tests/release_tests.cpp.
+    template<typename Literal>
+    static constexpr auto parse(const char* source) {
+        if constexpr (Literal::value) {
+            return parseText<typename Literal::Char, Literal::size>(source);
+        } else {
+            return LiteralText<char, 1>{};
+        }
+    }
+
+    template<typename Char, Size N>
+    static void decrypt(const EncryptedLiteral<Char, N>& literal, Char* out) {
+        constexpr Size perWord = sizeof(QWord) / sizeof(Char);
+        for (Size block = 0; block * perWord < literal.length; ++block) {
+            QWord stream = mix(literal.seed, block);
+            Size end = std::min(block * perWord + perWord, literal.length);
+            for (Size i = block * perWord; i < end; ++i) {
+                out[i] = static_cast<Char>(literal.data[i] ^ static_cast<Char>(stream));
+                stream >>= 8 * sizeof(Char);
+            }
+        }
+        out[literal.length] = Char(0);
+    }
+
+private:
+    // Одно 64-битное слово гаммы на блок из 8 байт
+    static constexpr QWord mix(Byte seed, Size block) {
+        QWord x = (static_cast<QWord>(seed) + 1) * 0x9E3779B97F4A7C15ull + block * 0xBF58476D1CE4E5B9ull;
+        x ^= x >> 31;
+        x *= 0x94D049BB133111EBull;
+        x ^= x >> 29;
+        return x;
+    }
+
+    template<typename Char>
+    static constexpr Char keystream(Byte seed, Size i) {
+        constexpr Size perWord = sizeof(QWord) / sizeof(Char);
+        return static_cast<Char>(mix(seed, i / perWord) >> ((i % perWord) * 8 * sizeof(Char)));
+    }
+
+    template<typename Char, Size N>
+    static constexpr LiteralText<Char, N> parseText(const char* source) {
+        LiteralText<Char, N> result{};
+        Size length = 0;
+        Size pos = 0;
+        bool found = false;
+        for (;;) {
+            while (isSpace(source[pos])) ++pos;
+            if (!source[pos]) break;
+            if (std::is_same_v<Char, wchar_t> && source[pos] == 'L') ++pos;
+            if (source[pos] != '"') return result;
+            ++pos;
+            while (source[pos] != '"') {
+                QWord value = 0;
+                if (!source[pos]) {
+                    return result;
+                } else if (source[pos] != '\\') {
+                    value = static_cast<Byte>(source[pos++]);
+                    if (!std::is_same_v<Char, char> && value >= 0x80) return result;
+                } else if (!unescape(source, ++pos, value) ||
+                           value > static_cast<std::make_unsigned_t<Char>>(~Char(0))) {
+                    return result;
+                }
+                if (length + 1 >= N) return result;
+                result.data[length++] = static_cast<Char>(value);
+            }
+            ++pos;
+            found = true;
+        }
+        result.valid = found && length + 1 == N;
+        return result;
+    }
+
+    // Разбирает последовательность после '\\', pos указывает на её первый символ
+    static constexpr bool unescape(const char* source, Size& pos, QWord& value) {
+        char c = source[pos++];
+        switch (c) {
+            case 'n': value = '\n'; return true;
+            case 't': value = '\t'; return true;
+            case 'r': value = '\r'; return true;
+            case 'v': value = '\v'; return true;
+            case 'b': value = '\b'; return true;
+            case 'f': value = '\f'; return true;
+            case 'a': value = '\a'; return true;
+            case '\\': case '\'': case '"': case '?':
+                value = static_cast<Byte>(c);
+                return true;
+            case 'x': {
+                Size digits = 0;
+                for (int digit = hexDigit(source[pos]); digit >= 0; digit = hexDigit(source[++pos])) {
+                    if (++digits > 8) return false;
+                    value = value * 16 + static_cast<QWord>(digit);
+                }
+                return digits > 0;
+            }
+            default:
+                if (c < '0' || c > '7') return false;
+                value = static_cast<QWord>(c - '0');
+                for (Size digits = 1; digits < 3 && source[pos] >= '0' && source[pos] <= '7'; ++digits) {
+                    value = value * 8 + static_cast<QWord>(source[pos++] - '0');
+                }
+                return true;
+        }
+    }
+
+    static constexpr int hexDigit(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    static constexpr bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+    }
+};
+
+// Звено интрузивного двусвязного кольцевого списка
+struct CacheLink {
+    CacheLink* prev = this;
+    CacheLink* next = this;
+    
+    CacheLink() = default;
+    CacheLink(const CacheLink&) = delete;
+    CacheLink& operator=(const CacheLink&) = delete;
+    ~CacheLink() { unlink(); }
+    
+    bool empty() const { return next == this; }
+    
+    void unlink() {
+        prev->next = next;
+        next->prev = prev;
+        prev = next = this;
+    }
+    
+    void pushBack(CacheLink* link) {
+        link->prev = prev;
+        link->next = this;
+        prev->next = link;
+        prev = link;
+    }
+    
+    // Переносит все элементы other в конец списка за O(1)
+    void splice(CacheLink& other) {
+        if (other.empty()) return;
+        other.next->prev = prev;
+        other.prev->next = this;
+        prev->next = other.next;
+        prev = other.prev;
+        other.prev = other.next = &other;
+    }
+};
+
+// Состояние кэша для мониторинга
+struct CacheStats {
+    Size bytes = 0;
+    Size entries = 0;
+    Size evictions = 0;
+    Size rejected = 0;
+    Size budget = 0;
+    Size hits = 0;
+    Size misses = 0;
+    Size prewarmedHits = 0;  // попадания в значения, подготовленные до ротации
+    Size expirations = 0;    // удалены по сроку или по эпохе ключа
+    Size lockWaits = 0;      // захваты уже занятого мьютекса шарда
+    QWord lockWaitNanos = 0; // суммарное ожидание таких захватов
+};
+
+// Захват мьютекса шарда с учётом ожидания. Время замеряется, только если
+// мьютекс занят, поэтому свободный захват стоит как обычный lock().
+// Счётчики шарда пишутся уже под захваченным мьютексом.
+template<typename Shard>
+std::unique_lock<std::mutex> lockShard(Shard& shard) {
+    std::unique_lock<std::mutex> lock(shard.mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+#if FEELMEHAPPY_METRICS
+        auto start = std::chrono::steady_clock::now();
+        lock.lock();
+        auto waited = std::chrono::steady_clock::now() - start;
+        ++shard.lockWaits;
+        shard.lockWaitNanos += static_cast<QWord>(std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count());
+#else
+        lock.lock();
+#endif
+    }
+    return lock;
+}
+
+// Счётчики преобразований по типам данных. Каждый поток пишет в свой
+// слот размером в строки кэша без атомарных read-modify-write, слоты
+// суммируются только при снятии снимка. Слот завершившегося потока
+// достаётся следующему новому потоку вместе с накопленными значениями.
+class Metrics {
+public:
+    using DataType = TypeDetector::DataType;
+    static constexpr Size kTypes = static_cast<Size>(DataType::Binary) + 1;
+    
+    struct TypeCounters {
+        QWord transforms = 0;
+        QWord bytes = 0;
+    };
+    
+private:
+    struct alignas(64) Slot {
+        std::atomic<QWord> values[kTypes][2] = {};
+        std::atomic<bool> owned{true};
+        Slot* next = nullptr;
+    };
+    
+    struct Release {
+        Slot*& slot;
+        ~Release() {
+            slot->owned.store(false, std::memory_order_release);
+            slot = nullptr;
+        }
+    };
+    
+    inline static std::atomic<Slot*> slots{nullptr};
+    
+    static Slot*& local() {
+        thread_local Slot* slot = nullptr;
+        return slot;
+    }
+    
+    static FEELMEHAPPY_NOINLINE Slot& acquire() {
+        Slot*& slot = local();
+        for (Slot* candidate = slots.load(std::memory_order_acquire); candidate; candidate = candidate->next) {
+            bool owned = false;
+            if (!candidate->owned.load(std::memory_order_relaxed) &&
+                candidate->owned.compare_exchange_strong(owned, true, std::memory_order_acquire)) {
+                slot = candidate;
+                break;
+            }
+        }
+        if (!slot) {
+            slot = new Slot();
+            slot->next = slots.load(std::memory_order_relaxed);
+            while (!slots.compare_exchange_weak(slot->next, slot, std::memory_order_release)) {}
+        }
+        thread_local Release release{slot};
+        return *slot;
+    }
+    
+    static void bump(std::atomic<QWord>& counter, QWord amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+    
+public:
+    // Преобразования текущего потока: по ним профиль мест вызова
+    // отличает вычисленный результат от взятого из кэша
+    static QWord& threadTransforms() {
+        thread_local QWord count = 0;
+        return count;
+    }
+    
+    static void recordTransform(DataType type, Size bytes) {
+        ++threadTransforms();
+#if FEELMEHAPPY_METRICS
+        Slot* slot = local();
+        auto& counters = (slot ? *slot : acquire()).values[static_cast<Size>(type)];
+        bump(counters[0], 1);
+        bump(counters[1], bytes);
+#else
+        (void)type;
+        (void)bytes;
+#endif
+    }
+    
+    static std::array<TypeCounters, kTypes> collect() {
+        std::array<TypeCounters, kTypes> result{};
+        for (Slot* slot = slots.load(std::memory_order_acquire); slot; slot = slot->next) {
+            for (Size t = 0; t < kTypes; ++t) {
+                result[t].transforms += slot->values[t][0].load(std::memory_order_relaxed);
+                result[t].bytes += slot->values[t][1].load(std::memory_order_relaxed);
+            }
+        }
+        return result;
+    }
+    
+    static const char* typeName(DataType type) {
+        static const char* const names[kTypes] = {
+            "unknown", "cstring", "wide_string", "std_string", "std_wstring", "integer", "float",
+            "double", "boolean", "pointer", "array", "struct", "char", "byte_array", "path", "url",
+            "email", "ip", "hex", "base64", "date_time", "uuid", "json", "xml", "sql", "code", "binary"
+        };
+        return names[static_cast<Size>(type)];
+    }
+};
+
+// Снимок метрик всех кэшей и преобразований
+struct MetricsSnapshot {
+    static constexpr Size kCaches = 4;
+    static constexpr const char* kCacheNames[kCaches] = {
+        "string", "wstring", "cstring_pool", "wcstring_pool"
+    };
+    
+    std::array<CacheStats, kCaches> caches{};  // в порядке UniversalObfuscator::CacheKind
+    std::array<Metrics::TypeCounters, Metrics::kTypes> types{};
+    
+    // Текстовый формат экспозиции Prometheus
+    std::string prometheus() const {
+        std::ostringstream out;
+        auto cacheFamily = [&](const char* name, const char* type, const char* help, auto field) {
+            out << "# HELP feelmehappy_" << name << ' ' << help << "\n"
+                << "# TYPE feelmehappy_" << name << ' ' << type << "\n";
+            for (Size i = 0; i < kCaches; ++i) {
+                out << "feelmehappy_" << name << "{cache=\"" << kCacheNames[i] << "\"} " << field(caches[i]) << "\n";
+            }
+        };
+        cacheFamily("cache_calls_total", "counter", "Cache lookups.",
+                    [](const CacheStats& c) { return c.hits + c.misses; });
+        cacheFamily("cache_hits_total", "counter", "Lookups answered from the cache.",
+                    [](const CacheStats& c) { return c.hits; });
+        cacheFamily("cache_misses_total", "counter", "Lookups that computed the value.",
+                    [](const CacheStats& c) { return c.misses; });
+        cacheFamily("cache_expirations_total", "counter", "Entries removed by age or key epoch.",
+                    [](const CacheStats& c) { return c.expirations; });
+        cacheFamily("cache_evictions_total", "counter", "Entries evicted by the memory budget.",
+                    [](const CacheStats& c) { return c.evictions; });
+        cacheFamily("cache_rejections_total", "counter", "New keys not admitted by the frequency sketch.",
+                    [](const CacheStats& c) { return c.rejected; });
+        cacheFamily("cache_lock_waits_total", "counter", "Shard lock acquisitions that had to wait.",
+                    [](const CacheStats& c) { return c.lockWaits; });
+        cacheFamily("cache_lock_wait_seconds_total", "counter", "Time spent waiting for shard locks.",
+                    [](const CacheStats& c) { return static_cast<double>(c.lockWaitNanos) / 1e9; });
+        cacheFamily("cache_entries", "gauge", "Entries currently stored.",
+                    [](const CacheStats& c) { return c.entries; });
+        cacheFamily("cache_memory_bytes", "gauge", "Accounted cache memory.",
+                    [](const CacheStats& c) { return c.bytes; });
+        
+        auto typeFamily = [&](const char* name, const char* help, auto field) {
+            out << "# HELP feelmehappy_" << name << ' ' << help << "\n"
+                << "# TYPE feelmehappy_" << name << " counter\n";
+            for (Size t = 0; t < Metrics::kTypes; ++t) {
+                out << "feelmehappy_" << name << "{type=\"" << Metrics::typeName(static_cast<Metrics::DataType>(t))
+                    << "\"} " << field(types[t]) << "\n";
+            }
+        };
+        typeFamily("transforms_total", "Values transformed, by detected data type.",
+                   [](const Metrics::TypeCounters& c) { return c.transforms; });
+        typeFamily("transformed_bytes_total", "Bytes transformed, by detected data type.",
+                   [](const Metrics::TypeCounters& c) { return c.bytes; });
+        return out.str();
+    }
+};
+
+// Оценка памяти, занимаемой значением в куче (без самого объекта)
+struct HeapUsage {
+    template<typename T>
+    static Size of(const T&) {
+        return 0;
+    }
+    
+    template<typename Char>
+    static Size of(const std::basic_string<Char>& str) {
+        // Короткие строки хранятся внутри объекта (SSO) и кучу не занимают
+        const char* data = reinterpret_cast<const char*>(str.data());
+        const char* self = reinterpret_cast<const char*>(&str);
+        std::less<const char*> less;
+        bool inlineStorage = !less(data, self) && less(data, self + sizeof(str));
+        return inlineStorage ? 0 : (str.capacity() + 1) * sizeof(Char);
+    }
+};
+
+// Статистика одного места вызова FEEL. Создаётся статической переменной
+// на месте вызова и попадает в общий список при первом замере, без
+// блокировок. Гистограмма логарифмическая: корзина b - от 2^b до 2^(b+1) нс.
+class CallSite {
+public:
+    static constexpr Size kBuckets = 40;
+    
+    const char* const file;
+    const unsigned line;
+    std::atomic<QWord> samples{0};
+    std::atomic<QWord> misses{0};
+    std::atomic<QWord> nanos{0};
+    std::array<std::atomic<QWord>, kBuckets> histogram{};
+    std::atomic<bool> registered{false};
+    CallSite* next = nullptr;
+    
+    constexpr CallSite(const char* sourceFile, unsigned sourceLine) : file(sourceFile), line(sourceLine) {}
+    
+    CallSite(const CallSite&) = delete;
+    CallSite& operator=(const CallSite&) = delete;
+    
+    static Size bucketOf(QWord ns) {
+        Size bucket = 0;
+        while (ns > 1 && bucket + 1 < kBuckets) {
+            ns >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+};
+
+// Сводка места вызова; вызовы, промахи и время - оценки по выборке
+struct CallSiteReport {
+    const char* file = nullptr;
+    unsigned line = 0;
+    QWord calls = 0;
+    QWord misses = 0;
+    QWord totalNanos = 0;
+    std::array<QWord, CallSite::kBuckets> histogram{};  // замеры без масштабирования
+    
+    QWord hits() const {
+        return calls - misses;
+    }
+    
+    // Верхняя граница корзины, в которую попадает квантиль q
+    QWord percentileNanos(double q) const {
+        QWord total = 0;
+        for (QWord count : histogram) {
+            total += count;
+        }
+        QWord seen = 0;
+        for (Size b = 0; b < CallSite::kBuckets; ++b) {
+            seen += histogram[b];
+            if (total != 0 && static_cast<double>(seen) >= q * static_cast<double>(total)) {
+                return QWord(2) << b;
+            }
+        }
+        return 0;
+    }
+};
+
+// Реестр мест вызова: односвязный список, пополняемый через CAS
+class CallSiteProfiler {
+private:
+    inline static std::atomic<CallSite*> sites{nullptr};
+    
+public:
+    static constexpr QWord kSamplePeriod = FEELMEHAPPY_PROFILE_SAMPLE > 0 ? FEELMEHAPPY_PROFILE_SAMPLE : 1;
+    
+    // Обратный отсчёт потока до следующего замера
+    static QWord& countdown() {
+        thread_local QWord remaining = 1;
+        return remaining;
+    }
+    
+    static void record(CallSite& site, QWord ns, bool missed) {
+        if (!site.registered.load(std::memory_order_acquire) &&
+            !site.registered.exchange(true, std::memory_order_acq_rel)) {
+            site.next = sites.load(std::memory_order_relaxed);
+            while (!sites.compare_exchange_weak(site.next, &site, std::memory_order_release)) {}
+        }
+        site.samples.fetch_add(1, std::memory_order_relaxed);
+        site.nanos.fetch_add(ns, std::memory_order_relaxed);
+        site.histogram[CallSite::bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+        if (missed) {
+            site.misses.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    
+    // Места вызова по убыванию суммарного времени
+    static std::vector<CallSiteReport> top(Size count) {
+        std::vector<CallSiteReport> reports;
+        for (CallSite* site = sites.load(std::memory_order_acquire); site; site = site->next) {
+            CallSiteReport report;
+            report.file = site->file;
+            report.line = site->line;
+            report.calls = site->samples.load(std::memory_order_relaxed) * kSamplePeriod;
+            report.misses = site->misses.load(std::memory_order_relaxed) * kSamplePeriod;
+            report.totalNanos = site->nanos.load(std::memory_order_relaxed) * kSamplePeriod;
+            for (Size b = 0; b < CallSite::kBuckets; ++b) {
+                report.histogram[b] = site->histogram[b].load(std::memory_order_relaxed);
+            }
+            reports.push_back(report);
+        }
+        std::sort(reports.begin(), reports.end(), [](const CallSiteReport& a, const CallSiteReport& b) {
+            return a.totalNanos > b.totalNanos;
+        });
+        if (reports.size() > count) {
+            reports.resize(count);
+        }
+        return reports;
+    }
+    
+    // Таблица top(count) для журнала
+    static std::string dump(Size count = 20) {
+        std::ostringstream out;
+        out << std::left << std::setw(48) << "site" << std::right
+            << std::setw(12) << "calls" << std::setw(10) << "hit %"
+            << std::setw(12) << "total ms" << std::setw(10) << "mean ns"
+            << std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns" << "\n";
+        for (const auto& report : top(count)) {
+            std::string site = std::string(report.file) + ":" + std::to_string(report.line);
+            double hitRate = report.calls ? 100.0 * static_cast<double>(report.hits()) / static_cast<double>(report.calls) : 0.0;
+            out << std::left << std::setw(48) << site << std::right
+                << std::setw(12) << report.calls
+                << std::setw(10) << std::fixed << std::setprecision(1) << hitRate
+                << std::setw(12) << std::setprecision(3) << static_cast<double>(report.totalNanos) / 1e6
+                << std::setw(10) << std::setprecision(0)
+                << (report.calls ? static_cast<double>(report.totalNanos) / static_cast<double>(report.calls) : 0.0)
+                << std::setw(10) << report.percentileNanos(0.5)
+                << std::setw(10) << report.percentileNanos(0.99) << "\n";
+        }
+        return out.str();
+    }
+    
+    // Обнуляет счётчики; места вызова остаются в реестре
+    static void reset() {
+        for (CallSite* site = sites.load(std::memory_order_acquire); site; site = site->next) {
+            site->samples.store(0, std::memory_order_relaxed);
+            site->misses.store(0, std::memory_order_relaxed);
+            site->nanos.store(0, std::memory_order_relaxed);
+            for (auto& bucket : site->histogram) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+// Замер одного вызова на месте вызова: вне выборки - только уменьшение
+// счётчика потока, в выборке - два чтения часов и запись в CallSite
+class CallSiteScope {
+private:
+    CallSite* site = nullptr;
+    std::chrono::steady_clock::time_point start;
+    QWord transformsBefore = 0;
+    
+public:
+    explicit CallSiteScope(CallSite& callSite) {
+        QWord& remaining = CallSiteProfiler::countdown();
+        if (--remaining != 0) return;
+        remaining = CallSiteProfiler::kSamplePeriod;
+        site = &callSite;
+        transformsBefore = Metrics::threadTransforms();
+        start = std::chrono::steady_clock::now();
+    }
+    
+    ~CallSiteScope() {
+        if (!site) return;
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        QWord ns = static_cast<QWord>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        CallSiteProfiler::record(*site, ns, Metrics::threadTransforms() != transformsBefore);
+    }
+    
+    CallSiteScope(const CallSiteScope&) = delete;
+    CallSiteScope& operator=(const CallSiteScope&) = delete;
+};
+
+// Частотный скетч count-min с 4-битными счётчиками (TinyLFU).
+// Счётчики периодически делятся пополам, чтобы старая популярность угасала.
+class FrequencySketch {
+private:
+    static constexpr Size kHashes = 4;
+    static constexpr Size kIndexBits = 13;
+    static constexpr Size kCounters = Size(1) << kIndexBits;
+    static constexpr Size kSampleSize = kCounters * 10;
+    
+    std::unique_ptr<QWord[]> table;  // 16 счётчиков в слове
+    Size additions = 0;
+    
+    static Size indexOf(QWord hash, Size i) {
+        return static_cast<Size>(hash >> (i * kIndexBits)) & (kCounters - 1);
+    }
+    
+    Byte counterAt(Size index) const {
+        return static_cast<Byte>((table[index >> 4] >> ((index & 15) * 4)) & 0xF);
+    }
+    
+    void age() {
+        for (Size i = 0; i < kCounters / 16; ++i) {
+            table[i] = (table[i] >> 1) & 0x7777777777777777ull;
+        }
+        additions /= 2;
+    }
+    
+public:
+    bool enabled() const {
+        return table != nullptr;
+    }
+    
+    void enable() {
+        if (!table) {
+            table.reset(new QWord[kCounters / 16]());
+        }
+    }
+    
+    Byte estimate(QWord hash) const {
+        Byte result = 0xF;
+        for (Size i = 0; i < kHashes; ++i) {
+            result = std::min(result, counterAt(indexOf(hash, i)));
+        }
+        return result;
+    }
+    
+    // Консервативное увеличение: растут только минимальные счётчики.
+    // Возвращает новую оценку частоты.
+    Byte increment(QWord hash) {
+        Byte current = estimate(hash);
+        if (current < 0xF) {
+            for (Size i = 0; i < kHashes; ++i) {
+                Size index = indexOf(hash, i);
+                if (counterAt(index) == current) {
+                    table[index >> 4] += QWord(1) << ((index & 15) * 4);
+                }
+            }
+            ++current;
+        }
+        if (++additions >= kSampleSize) {
+            age();
+        }
+        return current;
+    }
+};
+
+// Группа управляющих байтов плоской таблицы. Пустой слот - kEmpty,
+// удалённый - kDeleted, занятый хранит 7 младших битов хэша записи.
+// Вся группа сравнивается одной векторной инструкцией; в маске совпадений
+// на каждый слот приходится kStride битов, из них установлен не больше одного.
+struct ControlGroup {
+    static constexpr Byte kEmpty = 0x80;
+    static constexpr Byte kDeleted = 0xFE;
+    
+#if defined(FEELMEHAPPY_SSE2)
+    static constexpr Size kWidth = 16;
+    static constexpr Size kStride = 1;
+    using Mask = DWord;
+    
+    static Mask match(const Byte* group, Byte value) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        __m128i equal = _mm_cmpeq_epi8(bytes, _mm_set1_epi8(static_cast<char>(value)));
+        return static_cast<Mask>(_mm_movemask_epi8(equal));
+    }
+    
+    static Mask matchEmpty(const Byte* group) {
+        return match(group, kEmpty);
+    }
+    
+    static Mask matchEmptyOrDeleted(const Byte* group) {
+        return static_cast<Mask>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group))));
+    }
+#elif defined(FEELMEHAPPY_NEON)
+    static constexpr Size kWidth = 16;
+    static constexpr Size kStride = 4;
+    using Mask = QWord;
+    
+    // Сужение сдвигом: по 4 бита на байт сравнения
+    static Mask toMask(uint8x16_t matches) {
+        uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(matches), 4);
+        return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0) & 0x8888888888888888ull;
+    }
+    
+    static Mask match(const Byte* group, Byte value) {
+        return toMask(vceqq_u8(vld1q_u8(group), vdupq_n_u8(value)));
+    }
+    
+    static Mask matchEmpty(const Byte* group) {
+        return match(group, kEmpty);
+    }
+    
+    static Mask matchEmptyOrDeleted(const Byte* group) {
+        return toMask(vcltq_s8(vreinterpretq_s8_u8(vld1q_u8(group)), vdupq_n_s8(0)));
+    }
+#else
+    static constexpr Size kWidth = 8;
+    static constexpr Size kStride = 8;
+    using Mask = QWord;
+    
+    static constexpr QWord kLow = 0x0101010101010101ull;
+    static constexpr QWord kHigh = 0x8080808080808080ull;
+    
+    static QWord load(const Byte* group) {
+        QWord word = 0;
+        for (Size i = 0; i < kWidth; ++i) {
+            word |= QWord(group[i]) << (i * 8);
+        }
+        return word;
+    }
+    
+    // SWAR-поиск нулевого байта. Перенос может дать ложное совпадение,
+    // но только на занятом слоте, а их вызывающий код всё равно проверяет.
+    static Mask match(const Byte* group, Byte value) {
+        QWord word = load(group) ^ (kLow * value);
+        return (word - kLow) & ~word & kHigh;
+    }
+    
+    // У kEmpty сброшен бит 1, у kDeleted установлен
+    static Mask matchEmpty(const Byte* group) {
+        QWord word = load(group);
+        return word & ~(word << 6) & kHigh;
+    }
+    
+    static Mask matchEmptyOrDeleted(const Byte* group) {
+        return load(group) & kHigh;
+    }
+#endif
+    
+    static Size indexOf(Mask mask) {
+        return countTrailingZeros(mask) / kStride;
+    }
+};
+
+// Индекс записей в стиле Swiss table: массив управляющих байтов и
+// параллельный массив указателей на записи. Пробирование идёт выровненными
+// группами по ControlGroup::kWidth слотов с треугольным шагом и
+// заканчивается на группе, где есть пустой слот. Полный хэш хранится в
+// записи (Entry::hash): совпадение 7-битного тега проверяется по нему до
+// сравнения ключей, а при перестройке ключи не хэшируются заново.
+// Таблица заполняется не больше чем на 7/8, удалённые слоты считаются
+// занятыми до следующей перестройки.
+template<typename Entry>
+class FlatIndex {
+private:
+    static constexpr Size kWidth = ControlGroup::kWidth;
+    
+    std::unique_ptr<Byte[]> control;
+    std::unique_ptr<Entry*[]> slots;
+    Size capacity = 0;
+    Size count = 0;
+    Size growthLeft = 0;
+    
+    static Byte tagOf(QWord hash) {
+        return static_cast<Byte>(hash & 0x7F);
+    }
+    
+    static bool isFull(Byte control) {
+        return control < ControlGroup::kEmpty;
+    }
+    
+    Size startOf(QWord hash) const {
+        return static_cast<Size>(hash >> 7) & (capacity - 1) & ~(kWidth - 1);
+    }
+    
+    // Первый пустой или удалённый слот на пути пробирования
+    Size freeSlot(QWord hash) const {
+        for (Size pos = startOf(hash), step = kWidth;; pos = (pos + step) & (capacity - 1), step += kWidth) {
+            auto free = ControlGroup::matchEmptyOrDeleted(&control[pos]);
+            if (free) {
+                return pos + ControlGroup::indexOf(free);
+            }
+        }
+    }
+    
+    void rehash(Size newCapacity) {
+        std::unique_ptr<Byte[]> oldControl = std::move(control);
+        std::unique_ptr<Entry*[]> oldSlots = std::move(slots);
+        Size oldCapacity = capacity;
+        
+        control.reset(new Byte[newCapacity]);
+        std::memset(control.get(), ControlGroup::kEmpty, newCapacity);
+        slots.reset(new Entry*[newCapacity]);
+        capacity = newCapacity;
+        growthLeft = capacity - capacity / 8 - count;
+        
+        for (Size i = 0; i < oldCapacity; ++i) {
+            if (isFull(oldControl[i])) {
+                QWord hash = oldSlots[i]->hash;
+                Size slot = freeSlot(hash);
+                control[slot] = tagOf(hash);
+                slots[slot] = oldSlots[i];
+            }
+        }
+    }
+    
+public:
+    FlatIndex() = default;
+    FlatIndex(const FlatIndex&) = delete;
+    FlatIndex& operator=(const FlatIndex&) = delete;
+    
+    template<typename Match>
+    Entry* find(QWord hash, Match&& match) const {
+        if (count == 0) return nullptr;
+        Byte tag = tagOf(hash);
+        for (Size pos = startOf(hash), step = kWidth;; pos = (pos + step) & (capacity - 1), step += kWidth) {
+            const Byte* group = &control[pos];
+            for (auto hits = ControlGroup::match(group, tag); hits; hits &= hits - 1) {
+                Entry* entry = slots[pos + ControlGroup::indexOf(hits)];
+                if (entry->hash == hash && match(*entry)) {
+                    return entry;
+                }
+            }
+            if (ControlGroup::matchEmpty(group)) return nullptr;
+        }
+    }
+    
+    // Запись с таким ключом в индексе отсутствует
+    void insert(QWord hash, Entry* entry) {
+        if (capacity == 0) {
+            rehash(kWidth);
+        }
+        Size slot = freeSlot(hash);
+        if (growthLeft == 0 && control[slot] == ControlGroup::kEmpty) {
+            // Если место заняли в основном удалённые слоты, размер не растёт
+            rehash(count < (capacity - capacity / 8) / 2 ? capacity : capacity * 2);
+            slot = freeSlot(hash);
+        }
+        growthLeft -= control[slot] == ControlGroup::kEmpty;
+        control[slot] = tagOf(hash);
+        slots[slot] = entry;
+        ++count;
+    }
+    
+    void erase(QWord hash, const Entry* entry) {
+        if (count == 0) return;
+        Byte tag = tagOf(hash);
+        for (Size pos = startOf(hash), step = kWidth;; pos = (pos + step) & (capacity - 1), step += kWidth) {
+            Byte* group = &control[pos];
+            for (auto hits = ControlGroup::match(group, tag); hits; hits &= hits - 1) {
+                Size slot = pos + ControlGroup::indexOf(hits);
+                if (slots[slot] != entry) continue;
+                // Группа с пустым слотом и так останавливает поиск,
+                // поэтому слот можно сразу сделать пустым
+                if (ControlGroup::matchEmpty(group)) {
+                    control[slot] = ControlGroup::kEmpty;
+                    ++growthLeft;
+                } else {
+                    control[slot] = ControlGroup::kDeleted;
+                }
+                --count;
+                return;
+            }
+            if (ControlGroup::matchEmpty(group)) return;
+        }
+    }
+    
+    // visit может удалить переданную запись, но не вставлять новые
+    template<typename Visit>
+    void forEach(Visit&& visit) {
+        for (Size i = 0; i < capacity; ++i) {
+            if (isFull(control[i])) {
+                visit(slots[i]);
+            }
+        }
+    }
+    
+    void clear() {
+        control.reset();
+        slots.reset();
+        capacity = count = growthLeft = 0;
+    }
+    
+    Size size() const {
+        return count;
+    }
+    
+    Size bytes() const {
+        return capacity * (sizeof(Byte) + sizeof(Entry*));
+    }
+};
+
+// Ключ и значение записи кэша
+template<typename Key, typename Value>
+class CacheStorage {
+private:
+    Key storedKey;
+    Value storedValue;
+    
+public:
+    const Key& key() const {
+        return storedKey;
+    }
+    
+    const Value& value() const {
+        return storedValue;
+    }
+    
+    bool matches(const Key& query) const {
+        return storedKey == query;
+    }
+    
+    // Присваивание переиспользует уже выделенную память значения
+    template<typename Source>
+    void assign(const Key& key, const Source& value) {
+        storedKey = key;
+        storedValue = value;
+    }
+    
+    void release() {
+        storedKey = Key();
+        storedValue = Value();
+    }
+    
+    Size heapBytes() const {
+        return HeapUsage::of(storedKey) + HeapUsage::of(storedValue);
+    }
+};
+
+// Строковые ключ и значение лежат подряд: внутри записи, если вместе
+// занимают не больше kInlineBytes, иначе одним блоком в куче. Блок
+// переиспользуется, пока в него помещается новая пара.
+template<typename Char>
+class CacheStorage<std::basic_string<Char>, std::basic_string<Char>> {
+public:
+    static constexpr Size kInlineBytes = 64;
+    
+private:
+    using View = std::basic_string_view<Char>;
+    using Traits = std::char_traits<Char>;
+    
+    static constexpr Size kInlineChars = kInlineBytes / sizeof(Char);
+    
+    struct HeapBlock {
+        Char* data;
+        Size capacity;
+    };
+    
+    Size keyLength = 0;
+    Size valueLength = 0;
+    union {
+        Char inlineChars[kInlineChars];
+        HeapBlock heap;
+    };
+    
+    bool onHeap() const {
+        return keyLength + valueLength > kInlineChars;
+    }
+    
+    const Char* chars() const {
+        return onHeap() ? heap.data : inlineChars;
+    }
+    
+public:
+    CacheStorage() {}
+    CacheStorage(const CacheStorage&) = delete;
+    CacheStorage& operator=(const CacheStorage&) = delete;
+    ~CacheStorage() { release(); }
+    
+    View key() const {
+        return View(chars(), keyLength);
+    }
+    
+    View value() const {
+        return View(chars() + keyLength, valueLength);
+    }
+    
+    bool matches(View query) const {
+        return query.size() == keyLength && Traits::compare(chars(), query.data(), keyLength) == 0;
+    }
+    
+    void assign(View key, View value) {
+        Size total = key.size() + value.size();
+        Char* target = inlineChars;
+        if (total > kInlineChars) {
+            if (!onHeap() || heap.capacity < total) {
+                release();
+                heap.data = new Char[total];
+                heap.capacity = total;
+            }
+            target = heap.data;
+        } else {
+            release();
+        }
+        Traits::copy(target, key.data(), key.size());
+        Traits::copy(target + key.size(), value.data(), value.size());
+        keyLength = key.size();
+        valueLength = value.size();
+    }
+    
+    void release() {
+        if (onHeap()) {
+            delete[] heap.data;
+        }
+        keyLength = valueLength = 0;
+    }
+    
+    Size heapBytes() const {
+        return onHeap() ? heap.capacity * sizeof(Char) : 0;
+    }
+};
+
+// Кэш обфусцированных данных.
+// Разбит на шарды по хэшу ключа, у каждого шарда своя блокировка,
+// поэтому потоки с разными ключами почти не конкурируют.
+//
+// Устаревание по кольцу поколений: запись попадает в корзину своего
+// интервала времени, корзина целиком переносится в список устаревших,
+// когда её интервал старше cacheDuration, а каждая вставка удаляет
+// из этого списка не больше kExpireBudget записей.
+//
+// Каждая запись помечена версией ключа (эпоха в старших битах, ключ в
+// младшем байте). После смены ключа записи не сбрасываются: читатель с
+// новой версией пересчитывает значение на месте, а не обновлённые за эпоху
+// записи удаляются фоном через reclaimOlderThan.
+//
+// Перед ротацией для самых востребованных ключей (hottest) можно заранее
+// посчитать значения под следующую версию (prepare). Они хранятся рядом
+// с таблицей и подменяют запись при первом обращении с новой версией.
+//
+// Записи хранятся в слэбе шарда и не перемещаются: на них ссылаются
+// списки поколений и плоский индекс (FlatIndex), освобождённые записи
+// переиспользуются. Строковые ключ и значение до 64 байт лежат прямо в
+// записи, поэтому поиск обходится без обращений к куче.
+//
+// Бюджет памяти делится поровну между шардами. При превышении записи
+// вытесняются по алгоритму CLOCK, начиная с самых старых поколений:
+// запись с битом обращения получает второй шанс и уходит в конец корзины.
+//
+// С включённым допуском новый ключ сохраняется только после того, как
+// частотный скетч насчитал для него minFrequency обращений: одноразовые
+// строки вычисляются, но не вытесняют горячие записи.
+template<typename Key, typename Value>
+class ObfuscationCache {
+private:
+    // На 64-битных платформах строковая запись занимает ровно две кэш-линии
+    struct alignas(64) CacheEntry : CacheLink {
+        QWord hash = 0;
+        CacheStorage<Key, Value> storage;
+        QWord version = 0;
+        std::chrono::steady_clock::time_point timestamp;
+        Word hits = 0;  // насыщающийся счётчик для выбора горячих ключей
+        bool referenced = false;
+    };
+    
+    struct PreparedEntry {
+        Value data;
+        QWord version = 0;
+        Size bytes = 0;
+    };
+    
+    using PreparedMap = std::unordered_map<Key, PreparedEntry>;
+    
+    // Запись в слэбе плюс слот индекса: указатель и управляющий байт
+    static constexpr Size kEntryOverhead = sizeof(CacheEntry) + sizeof(CacheEntry*) + sizeof(Byte);
+    // Узел таблицы подготовленных значений плюс указатель корзины и хэш
+    static constexpr Size kNodeOverhead = sizeof(typename PreparedMap::value_type) + 2 * sizeof(void*);
+    
+    static constexpr Size kShardBits = 6;
+    static constexpr Size kShardCount = Size(1) << kShardBits;
+    static constexpr QWord kGenerations = 16;
+    static constexpr Size kExpireBudget = 4;
+    static constexpr Size kPrefetchDistance = 4;
+    static constexpr Size kSlabChunk = 4;
+    static constexpr Size kSlabDoublings = 10;
+    
+    struct alignas(64) Shard {
+        // Списки объявлены до слэба: записи отцепляются от них при уничтожении
+        std::array<CacheLink, kGenerations> ring;
+        CacheLink expired;
+        CacheLink unused;  // свободные записи слэба
+        QWord oldestGeneration = 0;
+        bool started = false;
+        Size bytes = 0;
+        Size evictions = 0;
+        Size rejected = 0;
+        Size hits = 0;
+        Size misses = 0;
+        Size prewarmedHits = 0;
+        Size expirations = 0;
+        Size lockWaits = 0;
+        QWord lockWaitNanos = 0;
+        Byte minFrequency = 0;
+        FrequencySketch sketch;
+        
+        std::vector<std::unique_ptr<CacheEntry[]>> slab;
+        FlatIndex<CacheEntry> index;
+        PreparedMap prepared;
+        mutable std::mutex mutex;
+    };
+    
+    std::array<Shard, kShardCount> shards;
+    const std::chrono::steady_clock::duration cacheDuration;
+    const std::chrono::steady_clock::duration generationSpan;
+    std::atomic<Size> memoryBudget{0};
+    
+    static QWord hashOf(const Key& key) {
+        return static_cast<QWord>(std::hash<Key>{}(key)) * 0x9E3779B97F4A7C15ull;
+    }
+    
+    // Запросы к кэшу строк в виде string_view: std::hash даёт тот же хэш
+    template<typename Char>
+    static QWord hashOf(std::basic_string_view<Char> query) {
+        return static_cast<QWord>(std::hash<std::basic_string_view<Char>>{}(query)) * 0x9E3779B97F4A7C15ull;
+    }
+    
+    static const Key& keyOf(const Key& query, Key&) {
+        return query;
+    }
+    
+    template<typename Char>
+    static const Key& keyOf(std::basic_string_view<Char> query, Key& scratch) {
+        scratch.assign(query.data(), query.size());
+        return scratch;
+    }
+    
+    static void prefetch(const Key&) {}
+    
+    template<typename Char>
+    static void prefetch(std::basic_string_view<Char> query) {
+        FEELMEHAPPY_PREFETCH(query.data());
+    }
+    
+    // Старшие биты хэша выбирают шард, младшие - счётчики скетча
+    Shard& shardFor(QWord hash) {
+        return shards[hash >> (64 - kShardBits)];
+    }
+    
+    template<typename Query>
+    static CacheEntry* find(Shard& shard, QWord hash, const Query& key) {
+        return shard.index.find(hash, [&key](const CacheEntry& entry) { return entry.storage.matches(key); });
+    }
+    
+    static Size bytesOf(const CacheEntry& entry) {
+        return kEntryOverhead + entry.storage.heapBytes();
+    }
+    
+    // Слэб растёт кусками удваивающегося размера, память возвращается
+    // только при clear()
+    static CacheEntry* allocate(Shard& shard) {
+        if (shard.unused.empty()) {
+            Size chunk = kSlabChunk << std::min(shard.slab.size(), kSlabDoublings);
+            shard.slab.emplace_back(new CacheEntry[chunk]);
+            for (Size i = 0; i < chunk; ++i) {
+                shard.unused.pushBack(&shard.slab.back()[i]);
+            }
+        }
+        auto* entry = static_cast<CacheEntry*>(shard.unused.next);
+        entry->unlink();
+        entry->hits = 0;
+        return entry;
+    }
+    
+    bool admit(Shard& shard, QWord hash) {
+        if (shard.minFrequency <= 1) {
+            return true;
+        }
+        // Скетч выделяется при первом промахе шарда, а не при включении допуска
+        shard.sketch.enable();
+        if (shard.sketch.increment(hash) >= shard.minFrequency) {
+            return true;
+        }
+        ++shard.rejected;
+        return false;
+    }
+    
+    QWord generationOf(std::chrono::steady_clock::time_point time) const {
+        return static_cast<QWord>(time.time_since_epoch() / generationSpan);
+    }
+    
+    // Поколение g полностью устарело, когда текущее >= g + kGenerations - 1
+    void advance(Shard& shard, QWord generation) {
+        if (!shard.started) {
+            shard.oldestGeneration = generation;
+            shard.started = true;
+        }
+        if (generation >= shard.oldestGeneration + 2 * kGenerations) {
+            // Долгий простой: все корзины устарели
+            for (auto& bucket : shard.ring) {
+                shard.expired.splice(bucket);
+            }
+            shard.oldestGeneration = generation - (kGenerations - 2);
+        }
+        while (shard.oldestGeneration + kGenerations - 1 <= generation) {
+            shard.expired.splice(shard.ring[shard.oldestGeneration % kGenerations]);
+            ++shard.oldestGeneration;
+        }
+        
+        for (Size i = 0; i < kExpireBudget && !shard.expired.empty(); ++i) {
+            erase(shard, static_cast<CacheEntry*>(shard.expired.next));
+            ++shard.expirations;
+        }
+    }
+    
+    void erase(Shard& shard, CacheEntry* entry) {
+        shard.bytes -= bytesOf(*entry);
+        shard.index.erase(entry->hash, entry);
+        entry->storage.release();
+        entry->unlink();
+        shard.unused.pushBack(entry);
+    }
+    
+    static void touch(CacheEntry& entry) {
+        entry.referenced = true;
+        if (entry.hits != 0xFFFF) {
+            ++entry.hits;
+        }
+    }
+    
+    // Вытесняет одну запись: сначала устаревшие, затем CLOCK по поколениям
+    bool evictOne(Shard& shard) {
+        if (!shard.expired.empty()) {
+            erase(shard, static_cast<CacheEntry*>(shard.expired.next));
+            return true;
+        }
+        for (QWord g = shard.oldestGeneration; g < shard.oldestGeneration + kGenerations; ++g) {
+            CacheLink& bucket = shard.ring[g % kGenerations];
+            while (!bucket.empty()) {
+                auto* entry = static_cast<CacheEntry*>(bucket.next);
+                if (entry->referenced) {
+                    entry->referenced = false;
+                    entry->unlink();
+                    bucket.pushBack(entry);
+                    continue;
+                }
+                erase(shard, entry);
+                ++shard.evictions;
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    // Перезапись после смены ключа переиспользует память записи.
+    // Для строк ключом и значением может быть string_view.
+    template<typename Query, typename Source>
+    void insert(Shard& shard, QWord hash, const Query& key, const Source& value, QWord version,
+                std::chrono::steady_clock::time_point now) {
+        QWord generation = generationOf(now);
+        advance(shard, generation);
+        
+        CacheEntry* entry = find(shard, hash, key);
+        if (entry) {
+            entry->unlink();
+            shard.bytes -= bytesOf(*entry);
+        } else {
+            entry = allocate(shard);
+            entry->hash = hash;
+            shard.index.insert(hash, entry);
+        }
+        
+        entry->storage.assign(key, value);
+        entry->timestamp = now;
+        entry->version = version;
+        entry->referenced = false;
+        shard.bytes += bytesOf(*entry);
+        shard.ring[generation % kGenerations].pushBack(entry);
+        
+        Size budget = memoryBudget.load(std::memory_order_relaxed);
+        if (budget != 0) {
+            Size shardBudget = budget / kShardCount;
+            while (shard.bytes > shardBudget && evictOne(shard)) {}
+        }
+    }
+    
+public:
+    ObfuscationCache() : ObfuscationCache(std::chrono::minutes(15)) {}
+    
+    // memoryBudget в байтах, 0 - без ограничения
+    explicit ObfuscationCache(std::chrono::steady_clock::duration duration, Size budget = 0)
+        : cacheDuration(duration),
+          generationSpan(std::max<std::chrono::steady_clock::duration>(duration / (kGenerations - 2),
+                                                                        std::chrono::steady_clock::duration(1))),
+          memoryBudget(budget) {}
+    
+    // Новый бюджет применяется при следующих вставках
+    void setMemoryBudget(Size bytes) {
+        memoryBudget.store(bytes, std::memory_order_relaxed);
+    }
+    
+    // Допуск по частоте: новый ключ сохраняется с minFrequency-го обращения.
+    // Значения 0 и 1 сохраняют всё, скетч при этом не ведётся.
+    // Счётчики скетча насыщаются на 15.
+    void setAdmission(Byte minFrequency) {
+        for (auto& shard : shards) {
+            auto lock = lockShard(shard);
+            shard.minFrequency = std::min<Byte>(minFrequency, 0xF);
+        }
+    }
+    
+    CacheStats stats() const {
+        CacheStats result;
+        result.budget = memoryBudget.load(std::memory_order_relaxed);
+        for (const auto& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            result.bytes += shard.bytes;
+            result.entries += shard.index.size();
+            result.evictions += shard.evictions;
+            result.rejected += shard.rejected;
+            result.hits += shard.hits;
+            result.misses += shard.misses;
+            result.prewarmedHits += shard.prewarmedHits;
+            result.expirations += shard.expirations;
+            result.lockWaits += shard.lockWaits;
+            result.lockWaitNanos += shard.lockWaitNanos;
+        }
+        return result;
+    }
+    
+    void clear() {
+        for (auto& shard : shards) {
+            auto lock = lockShard(shard);
+            shard.index.clear();
+            shard.slab.clear();
+            shard.prepared.clear();
+            shard.bytes = 0;
+        }
+    }
+    
+    bool get(const Key& key, Value& value, QWord& version) {
+        QWord hash = hashOf(key);
+        Shard& shard = shardFor(hash);
+        auto lock = lockShard(shard);
+        CacheEntry* entry = find(shard, hash, key);
+        if (entry) {
+            auto now = std::chrono::steady_clock::now();
+            if (now - entry->timestamp < cacheDuration) {
+                touch(*entry);
+                value = entry->storage.value();
+                version = entry->version;
+                return true;
+            }
+            erase(shard, entry);
+            ++shard.expirations;
+        }
+        return false;
+    }
+    
+    // Ключ обфускации - младший байт версии
+    bool get(const Key& key, Value& value, Byte& storedKey) {
+        QWord version = 0;
+        bool found = get(key, value, version);
+        storedKey = static_cast<Byte>(version);
+        return found;
+    }
+    
+    void put(const Key& key, const Value& value, QWord version) {
+        QWord hash = hashOf(key);
+        Shard& shard = shardFor(hash);
+        auto lock = lockShard(shard);
+        if (shard.minFrequency > 1 && !find(shard, hash, key) && !admit(shard, hash)) {
+            return;
+        }
+        insert(shard, hash, key, value, version, std::chrono::steady_clock::now());
+    }
+    
+    // Пакетный поиск: запросы упорядочиваются по шардам, и каждый шард
+    // блокируется один раз на все свои ключи. Запросом к кэшу строк может
+    // быть string_view: хэши совпадают, а ключи сравниваются без копирования.
+    // onHit(i, value) вызывается под блокировкой шарда (для строк value -
+    // string_view на данные записи), индексы промахов в порядке шардов
+    // дописываются в misses.
+    template<typename Query, typename OnHit>
+    void findBatch(const Query* queries, Size count, QWord version, OnHit&& onHit, std::vector<Size>& misses) {
+        thread_local std::vector<Size> order;
+        thread_local std::vector<QWord> hashes;
+        thread_local Key scratch;
+        std::array<Size, kShardCount + 1> starts{};
+        auto shardOf = [](QWord hash) { return static_cast<Size>(hash >> (64 - kShardBits)); };
+        
+        // Сортировка подсчётом по номеру шарда
+        order.resize(count);
+        hashes.resize(count);
+        for (Size i = 0; i < count; ++i) {
+            hashes[i] = hashOf(queries[i]);
+            ++starts[shardOf(hashes[i]) + 1];
+        }
+        for (Size s = 0; s < kShardCount; ++s) {
+            starts[s + 1] += starts[s];
+        }
+        std::array<Size, kShardCount> cursor;
+        std::copy(starts.begin(), starts.end() - 1, cursor.begin());
+        for (Size i = 0; i < count; ++i) {
+            order[cursor[shardOf(hashes[i])]++] = i;
+        }
         
-        // Очистка старых записей
         auto now = std::chrono::steady_clock::now();
-        for (auto it = cache.begin(); it != cache.end(); ) {
-            if (now - it->second.timestamp > cacheDuration) {
-                it = cache.erase(it);
+        for (Size s = 0; s < kShardCount; ++s) {
+            if (starts[s] == starts[s + 1]) continue;
+            Shard& shard = shards[s];
+            auto lock = lockShard(shard);
+            for (Size j = starts[s]; j < starts[s + 1]; ++j) {
+                if (j + kPrefetchDistance < starts[s + 1]) {
+                    prefetch(queries[order[j + kPrefetchDistance]]);
+                }
+                Size i = order[j];
+                CacheEntry* entry = find(shard, hashes[i], queries[i]);
+                if (entry && entry->version == version && now - entry->timestamp < cacheDuration) {
+                    touch(*entry);
+                    ++shard.hits;
+                    onHit(i, entry->storage.value());
+                    continue;
+                }
+                if (!shard.prepared.empty()) {
+                    auto ready = shard.prepared.find(keyOf(queries[i], scratch));
+                    if (ready != shard.prepared.end() && ready->second.version == version) {
+                        Value value = std::move(ready->second.data);
+                        shard.bytes -= ready->second.bytes;
+                        shard.prepared.erase(ready);
+                        insert(shard, hashes[i], queries[i], value, version, now);
+                        ++shard.hits;
+                        ++shard.prewarmedHits;
+                        onHit(i, value);
+                        continue;
+                    }
+                }
+                ++shard.misses;
+                misses.push_back(i);
+            }
+        }
+    }
+    
+    // Сохраняет посчитанные вне блокировки значения промахов findBatch,
+    // по одной блокировке на шард. Допуск - как в getOrCompute.
+    template<typename Query, typename ValueAt>
+    void storeBatch(const Query* queries, const Size* indices, Size count, QWord version, ValueAt&& valueAt) {
+        auto now = std::chrono::steady_clock::now();
+        Size j = 0;
+        QWord hash = count ? hashOf(queries[indices[0]]) : 0;
+        while (j < count) {
+            Shard& shard = shardFor(hash);
+            auto lock = lockShard(shard);
+            do {
+                Size i = indices[j];
+                if (find(shard, hash, queries[i]) || admit(shard, hash)) {
+                    insert(shard, hash, queries[i], valueAt(i), version, now);
+                }
+                if (++j < count) {
+                    hash = hashOf(queries[indices[j]]);
+                }
+            } while (j < count && &shardFor(hash) == &shard);
+        }
+    }
+    
+    // Поиск и вставка. При промахе значение считается без блокировки шарда,
+    // чтобы долгое преобразование не задерживало попадания в тот же шард;
+    // затем шард блокируется снова и запись перепроверяется, как в
+    // findBatch/storeBatch. Запись другой версии считается промахом и
+    // пересчитывается на месте.
+    template<typename Compute>
+    Value getOrCompute(const Key& key, QWord version, Compute&& compute) {
+        QWord hash = hashOf(key);
+        Shard& shard = shardFor(hash);
+        auto lock = lockShard(shard);
+        auto now = std::chrono::steady_clock::now();
+        
+        CacheEntry* entry = find(shard, hash, key);
+        if (entry && entry->version == version && now - entry->timestamp < cacheDuration) {
+            touch(*entry);
+            ++shard.hits;
+            return Value(entry->storage.value());
+        }
+        
+        if (!shard.prepared.empty()) {
+            auto ready = shard.prepared.find(key);
+            if (ready != shard.prepared.end() && ready->second.version == version) {
+                Value value = std::move(ready->second.data);
+                shard.bytes -= ready->second.bytes;
+                shard.prepared.erase(ready);
+                insert(shard, hash, key, value, version, now);
+                ++shard.hits;
+                ++shard.prewarmedHits;
+                return value;
+            }
+        }
+        
+        ++shard.misses;
+        lock.unlock();
+        
+        Value value = compute();
+        
+        lock = lockShard(shard);
+        now = std::chrono::steady_clock::now();
+        entry = find(shard, hash, key);
+        if (entry && entry->version == version && now - entry->timestamp < cacheDuration) {
+            // Другой поток успел сохранить то же значение
+            touch(*entry);
+            return value;
+        }
+        if (entry || admit(shard, hash)) {
+            insert(shard, hash, key, value, version, now);
+        }
+        return value;
+    }
+    
+    // Удаляет записи с версией меньше minVersion. Шарды обрабатываются
+    // по одному, блокировка не удерживается дольше прохода по шарду.
+    Size reclaimOlderThan(QWord minVersion) {
+        Size reclaimed = 0;
+        for (auto& shard : shards) {
+            auto lock = lockShard(shard);
+            shard.index.forEach([this, &shard, &reclaimed, minVersion](CacheEntry* entry) {
+                if (entry->version < minVersion) {
+                    erase(shard, entry);
+                    ++shard.expirations;
+                    ++reclaimed;
+                }
+            });
+            // Подготовленные значения, которые так и не понадобились
+            for (auto it = shard.prepared.begin(); it != shard.prepared.end();) {
+                if (it->second.version < minVersion) {
+                    shard.bytes -= it->second.bytes;
+                    it = shard.prepared.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        return reclaimed;
+    }
+    
+    // Самые востребованные ключи с прошлого вызова: счётчики обращений
+    // после выборки делятся пополам, чтобы учитывалась недавняя активность
+    std::vector<Key> hottest(Size count) {
+        if (count == 0) return {};
+        
+        using Candidate = std::pair<Word, Key>;
+        auto colder = [](const Candidate& a, const Candidate& b) { return a.first > b.first; };
+        std::vector<Candidate> heap;
+        
+        for (auto& shard : shards) {
+            auto lock = lockShard(shard);
+            shard.index.forEach([&heap, &colder, count](CacheEntry* entry) {
+                Word hits = entry->hits;
+                entry->hits = hits / 2;
+                if (hits == 0 || (heap.size() == count && hits <= heap.front().first)) return;
+                
+                heap.emplace_back(hits, Key(entry->storage.key()));
+                std::push_heap(heap.begin(), heap.end(), colder);
+                if (heap.size() > count) {
+                    std::pop_heap(heap.begin(), heap.end(), colder);
+                    heap.pop_back();
+                }
+            });
+        }
+        
+        std::sort_heap(heap.begin(), heap.end(), colder);
+        std::vector<Key> result;
+        result.reserve(heap.size());
+        for (auto& candidate : heap) {
+            result.push_back(std::move(candidate.second));
+        }
+        return result;
+    }
+    
+    // Заранее считает значение под будущую версию. Вычисление идёт без
+    // блокировки; если ключ за это время вытеснен, результат отбрасывается.
+    template<typename Compute>
+    void prepare(const Key& key, QWord version, Compute&& compute) {
+        Value value = compute();
+        
+        QWord hash = hashOf(key);
+        Shard& shard = shardFor(hash);
+        auto lock = lockShard(shard);
+        if (!find(shard, hash, key)) return;
+        
+        PreparedEntry& entry = shard.prepared[key];
+        shard.bytes -= entry.bytes;
+        entry.data = std::move(value);
+        entry.version = version;
+        entry.bytes = kNodeOverhead + HeapUsage::of(key) + HeapUsage::of(entry.data);
+        shard.bytes += entry.bytes;
+    }
+    
+    // Фоновое обслуживание: удаляет все устаревшие записи, не дожидаясь
+    // вставок в шард. Возвращает число удалённых записей.
+    Size expire(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) {
+        QWord generation = generationOf(now);
+        Size expired = 0;
+        for (auto& shard : shards) {
+            auto lock = lockShard(shard);
+            if (!shard.started) continue;
+            Size before = shard.index.size();
+            Size counted = shard.expirations;
+            advance(shard, generation);
+            while (!shard.expired.empty()) {
+                erase(shard, static_cast<CacheEntry*>(shard.expired.next));
+            }
+            shard.expirations = counted + (before - shard.index.size());
+            expired += before - shard.index.size();
+        }
+        return expired;
+    }
+    
+    void invalidate(const Key& key) {
+        QWord hash = hashOf(key);
+        Shard& shard = shardFor(hash);
+        auto lock = lockShard(shard);
+        if (CacheEntry* entry = find(shard, hash, key)) {
+            erase(shard, entry);
+        }
+    }
+    
+    Size size() const {
+        Size total = 0;
+        for (const auto& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            total += shard.index.size();
+        }
+        return total;
+    }
+};
+
+// Арена с выделением сдвигом указателя, память освобождается только целиком
+class Arena {
+private:
+    static constexpr Size kBlockSize = 64 * 1024;
+    
+    std::vector<std::unique_ptr<Byte[]>> blocks;
+    Byte* cursor = nullptr;
+    Size remaining = 0;
+    Size reserved = 0;
+    
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    
+    void* allocate(Size size, Size alignment) {
+        Size padding = (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) % alignment;
+        if (padding + size > remaining) {
+            // Крупные запросы получают отдельный блок, текущий продолжает заполняться
+            if (size > kBlockSize / 4) {
+                blocks.emplace_back(new Byte[size + alignment]);
+                reserved += size + alignment;
+                Byte* block = blocks.back().get();
+                return block + (alignment - reinterpret_cast<uintptr_t>(block) % alignment) % alignment;
+            }
+            blocks.emplace_back(new Byte[kBlockSize]);
+            reserved += kBlockSize;
+            cursor = blocks.back().get();
+            remaining = kBlockSize;
+            padding = (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) % alignment;
+        }
+        Byte* result = cursor + padding;
+        cursor += padding + size;
+        remaining -= padding + size;
+        return result;
+    }
+    
+    Size bytes() const {
+        return reserved;
+    }
+};
+
+// Аллокатор контейнеров поверх арены: освобождение узлов ничего не делает
+template<typename T>
+class ArenaAllocator {
+private:
+    Arena* arena;
+    
+    template<typename U> friend class ArenaAllocator;
+    
+public:
+    using value_type = T;
+    
+    explicit ArenaAllocator(Arena& owner) : arena(&owner) {}
+    
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+    
+    T* allocate(Size count) {
+        return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+    }
+    
+    void deallocate(T*, Size) {}
+    
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& other) const {
+        return arena == other.arena;
+    }
+    
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const {
+        return arena != other.arena;
+    }
+};
+
+// Пул обфусцированных C-строк с постоянными адресами.
+// Ключи, результаты и узлы индекса живут в арене поколения. При ротации
+// текущее поколение становится предыдущим, а предыдущее освобождается
+// целиком, поэтому указатель остаётся действительным до второй ротации.
+// Сверх бюджета памяти шарда арена не растёт: уже сохранённые строки
+// по-прежнему находятся, а результат для остальных строится в кольце из
+// kScratchSlots буферов потока и действителен, пока этот поток не сделает
+// ещё kScratchSlots таких вызовов.
+template<typename Char>
+class InternPool {
+private:
+    using View = std::basic_string_view<Char>;
+    
+    struct Interned {
+        const Char* value;
+        QWord version;
+    };
+    
+    struct Generation {
+        Arena arena;  // объявлена первой: индекс уничтожается раньше неё
+        std::unordered_map<View, Interned, std::hash<View>, std::equal_to<View>,
+                           ArenaAllocator<std::pair<const View, Interned>>> index;
+        
+        Generation() : index(0, std::hash<View>(), std::equal_to<View>(),
+                             ArenaAllocator<std::pair<const View, Interned>>(arena)) {}
+    };
+    
+    static constexpr Size kShardBits = 4;
+    static constexpr Size kShardCount = Size(1) << kShardBits;
+    
+public:
+    static constexpr Size kScratchSlots = 8;
+    
+private:
+    struct alignas(64) Shard {
+        std::unique_ptr<Generation> current = std::make_unique<Generation>();
+        std::unique_ptr<Generation> previous;
+        Size hits = 0;
+        Size misses = 0;
+        Size rejected = 0;   // построены вне арены из-за бюджета
+        Size lockWaits = 0;
+        QWord lockWaitNanos = 0;
+        mutable std::mutex mutex;
+    };
+    
+    std::array<Shard, kShardCount> shards;
+    std::atomic<Size> memoryBudget;
+    
+    Shard& shardFor(View input) {
+        QWord hash = static_cast<QWord>(std::hash<View>{}(input)) * 0x9E3779B97F4A7C15ull;
+        return shards[hash >> (64 - kShardBits)];
+    }
+    
+    static Char* copy(Arena& arena, View input) {
+        Char* result = static_cast<Char*>(arena.allocate((input.size() + 1) * sizeof(Char), alignof(Char)));
+        std::memcpy(result, input.data(), input.size() * sizeof(Char));
+        result[input.size()] = Char(0);
+        return result;
+    }
+    
+    // Копия входа в очередном буфере кольца потока
+    static Char* scratch(View input) {
+        thread_local std::array<std::basic_string<Char>, kScratchSlots> buffers;
+        thread_local Size next = 0;
+        std::basic_string<Char>& buffer = buffers[next++ % kScratchSlots];
+        buffer.assign(input.data(), input.size());
+        return &buffer[0];
+    }
+    
+    // Возвращает освобождаемое поколение, чтобы уничтожить его вне блокировки
+    static std::unique_ptr<Generation> retire(Shard& shard) {
+        std::unique_ptr<Generation> released = std::move(shard.previous);
+        shard.previous = std::move(shard.current);
+        shard.current = std::make_unique<Generation>();
+        return released;
+    }
+    
+public:
+    explicit InternPool(Size budget = 0) : memoryBudget(budget) {}
+    
+    // Возвращает сохранённый результат или строит его: transform получает
+    // копию входа в арене и преобразует её на месте
+    template<typename Transform>
+    const Char* intern(View input, QWord version, Transform&& transform) {
+        Shard& shard = shardFor(input);
+        std::unique_lock<std::mutex> lock = lockShard(shard);
+        Generation& generation = *shard.current;
+        
+        auto it = generation.index.find(input);
+        if (it != generation.index.end() && it->second.version == version) {
+            ++shard.hits;
+            return it->second.value;
+        }
+        
+        ++shard.misses;
+        
+        // Поколение нельзя освободить раньше срока: его указатели уже выданы.
+        // Поэтому сверх бюджета результат строится вне арены и вне блокировки.
+        Size budget = memoryBudget.load(std::memory_order_relaxed);
+        if (budget != 0 && generation.arena.bytes() > budget / kShardCount) {
+            ++shard.rejected;
+            lock.unlock();
+            Char* value = scratch(input);
+            transform(value, input.size());
+            return value;
+        }
+        
+        Char* value = copy(generation.arena, input);
+        transform(value, input.size());
+        if (it != generation.index.end()) {
+            it->second = Interned{value, version};
+            return value;
+        }
+        
+        Char* stored = copy(generation.arena, input);
+        generation.index.emplace(View(stored, input.size()), Interned{value, version});
+        return value;
+    }
+    
+    // Смена эпохи ключа: освобождает позапрошлое поколение целиком
+    void rotate() {
+        for (auto& shard : shards) {
+            std::unique_ptr<Generation> released;
+            {
+                auto lock = lockShard(shard);
+                released = retire(shard);
+            }
+        }
+    }
+    
+    void setMemoryBudget(Size bytes) {
+        memoryBudget.store(bytes, std::memory_order_relaxed);
+    }
+    
+    CacheStats stats() const {
+        CacheStats result;
+        result.budget = memoryBudget.load(std::memory_order_relaxed);
+        for (const auto& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            result.bytes += shard.current->arena.bytes();
+            result.entries += shard.current->index.size();
+            result.hits += shard.hits;
+            result.misses += shard.misses;
+            result.rejected += shard.rejected;
+            result.lockWaits += shard.lockWaits;
+            result.lockWaitNanos += shard.lockWaitNanos;
+            if (shard.previous) {
+                result.bytes += shard.previous->arena.bytes();
+            }
+        }
+        return result;
+    }
+};
+
+// Объект, создаваемый при первом обращении. Пока тип данных не
+// используется, соответствующая подсистема не стоит ни памяти, ни времени.
+template<typename T>
+class Lazy {
+private:
+    std::atomic<T*> object{nullptr};
+    std::mutex mutex;
+    std::function<std::unique_ptr<T>()> factory;
+    
+    FEELMEHAPPY_NOINLINE T* create() {
+        std::lock_guard<std::mutex> lock(mutex);
+        T* current = object.load(std::memory_order_relaxed);
+        if (!current) {
+            current = factory().release();
+            object.store(current, std::memory_order_release);
+        }
+        return current;
+    }
+    
+public:
+    explicit Lazy(std::function<std::unique_ptr<T>()> make) : factory(std::move(make)) {}
+    
+    ~Lazy() {
+        delete object.load(std::memory_order_acquire);
+    }
+    
+    Lazy(const Lazy&) = delete;
+    Lazy& operator=(const Lazy&) = delete;
+    
+    T& get() {
+        T* current = object.load(std::memory_order_acquire);
+        return current ? *current : *create();
+    }
+    
+    T* operator->() {
+        return &get();
+    }
+    
+    // Без создания: nullptr, если объект ещё не понадобился
+    T* peek() const {
+        return object.load(std::memory_order_acquire);
+    }
+};
+
+// Планировщик таймеров: куча сроков и один поток, который спит на условной
+// переменной до ближайшего срока, поэтому остановка не ждёт долгих пауз.
+// Поток создаётся вместе с первым таймером (или по start()), так что
+// задачи выполняются, даже если приложение больше не вызывает FEEL.
+// Без фонового потока просроченные задачи выполняет tick().
+class Scheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimerId = QWord;
+    
+private:
+    struct Timer {
+        std::function<void()> task;
+        Clock::duration period;  // ноль - однократный таймер
+        Clock::time_point due;
+    };
+    
+    using Deadline = std::pair<Clock::time_point, TimerId>;
+    
+    std::unordered_map<TimerId, Timer> timers;
+    // Мин-куча сроков; записи отменённых и перенесённых таймеров пропускаются
+    std::vector<Deadline> deadlines;
+    TimerId nextId = 1;
+    bool stopping = false;
+    const bool background;
+    std::atomic<bool> started{false};
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::thread worker;
+    
+    static bool later(const Deadline& a, const Deadline& b) {
+        return a.first > b.first;
+    }
+    
+    void push(TimerId id, Clock::time_point due) {
+        deadlines.emplace_back(due, id);
+        std::push_heap(deadlines.begin(), deadlines.end(), later);
+    }
+    
+    void pop() {
+        std::pop_heap(deadlines.begin(), deadlines.end(), later);
+        deadlines.pop_back();
+    }
+    
+    // Забирает одну просроченную задачу, вызывается под блокировкой.
+    // Периодический таймер переносится на следующий срок после now:
+    // пропущенные за время простоя запуски не накапливаются.
+    bool takeDue(Clock::time_point now, std::function<void()>& task) {
+        while (!deadlines.empty()) {
+            Deadline top = deadlines.front();
+            auto it = timers.find(top.second);
+            if (it == timers.end() || it->second.due != top.first) {
+                pop();
+                continue;
+            }
+            if (top.first > now) return false;
+            pop();
+            
+            Timer& timer = it->second;
+            if (timer.period == Clock::duration::zero()) {
+                task = std::move(timer.task);
+                timers.erase(it);
+            } else {
+                timer.due += timer.period * ((now - timer.due) / timer.period + 1);
+                push(it->first, timer.due);
+                task = timer.task;
+            }
+            return true;
+        }
+        return false;
+    }
+    
+    // Вызывается под блокировкой
+    void launch() {
+        if (!background || stopping || started.load(std::memory_order_relaxed)) return;
+        worker = std::thread([this]() { run(); });
+        started.store(true, std::memory_order_release);
+    }
+    
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            std::function<void()> task;
+            if (takeDue(Clock::now(), task)) {
+                lock.unlock();
+                task();
+                lock.lock();
+            } else if (deadlines.empty()) {
+                wakeup.wait(lock);
             } else {
-                ++it;
+                wakeup.wait_until(lock, deadlines.front().first);
             }
         }
     }
     
-    void invalidate(const Key& key) {
+public:
+    explicit Scheduler(bool backgroundThread = true) : background(backgroundThread) {}
+    
+    ~Scheduler() {
+        stop();
+    }
+    
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+    
+    // Задача выполняется через delay, затем каждые period, если он задан.
+    // Задачи выполняются без блокировки и могут сами ставить таймеры.
+    // Первый таймер запускает фоновый поток.
+    TimerId schedule(Clock::duration delay, std::function<void()> task,
+                     Clock::duration period = Clock::duration::zero()) {
         std::lock_guard<std::mutex> lock(mutex);
-        cache.erase(key);
+        TimerId id = nextId++;
+        Clock::time_point due = Clock::now() + delay;
+        timers.emplace(id, Timer{std::move(task), period, due});
+        push(id, due);
+        launch();
+        wakeup.notify_one();
+        return id;
     }
     
-    Size size() const {
+    // Выполняющаяся в этот момент задача не прерывается
+    bool cancel(TimerId id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return timers.erase(id) != 0;
+    }
+    
+    // Запускает фоновый поток, если он разрешён и ещё не запущен
+    void start() {
+        std::lock_guard<std::mutex> lock(mutex);
+        launch();
+    }
+    
+    // Выполняет все задачи со сроком не позже now и возвращает их число.
+    // Для режима без фонового потока; now можно сдвинуть вперёд вручную.
+    Size tick(Clock::time_point now = Clock::now()) {
+        Size executed = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        std::function<void()> task;
+        while (takeDue(now, task)) {
+            lock.unlock();
+            task();
+            ++executed;
+            lock.lock();
+        }
+        return executed;
+    }
+    
+    Size pending() {
         std::lock_guard<std::mutex> lock(mutex);
-        return cache.size();
+        return timers.size();
+    }
+    
+    bool running() const {
+        return started.load(std::memory_order_acquire);
+    }
+    
+    // Будит поток и дожидается его завершения; таймеры остаются и
+    // могут выполняться через tick()
+    void stop() {
+        std::thread stopped;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            wakeup.notify_one();
+            stopped = std::move(worker);
+        }
+        if (stopped.joinable() && stopped.get_id() != std::this_thread::get_id()) {
+            stopped.join();
+        } else if (stopped.joinable()) {
+            stopped.detach();
+        }
     }
 };
 
@@ -433,52 +4169,35 @@ private:
     
     std::vector<GeneratedFunction> functions;
     std::mutex mutex;
-    std::atomic<bool> running{false};
-    std::thread generatorThread;
     
 public:
-    FunctionGenerator() {
-        running = true;
-        generatorThread = std::thread([this]() {
-            generationWorker();
-        });
-    }
+    FunctionGenerator() = default;
     
     ~FunctionGenerator() {
-        running = false;
-        if (generatorThread.joinable()) {
-            generatorThread.join();
-        }
         cleanup();
     }
     
-private:
-    void generationWorker() {
-        while (running) {
-            std::this_thread::sleep_for(std::chrono::minutes(15));
-            
-            // Генерируем от 100 до 500 функций
-            Size count = 100 + (KeyGenerator::generateByte() % 401);
-            
-            std::lock_guard<std::mutex> lock(mutex);
-            cleanup();
-            
-            for (Size i = 0; i < count; ++i) {
-                generateRandomFunction();
-            }
+    // Заменяет набор функций новым, вызывается планировщиком раз в 15 минут
+    void regenerate() {
+        // Генерируем от 100 до 500 функций
+        Size count = 100 + (KeyGenerator::generateByte() % 401);
+        
+        std::lock_guard<std::mutex> lock(mutex);
+        cleanup();
+        
+        for (Size i = 0; i < count; ++i) {
+            generateRandomFunction();
         }
     }
     
+private:
     void generateRandomFunction() {
 #ifdef FEELMEHAPPY_WINDOWS
         Size size = 64 + (KeyGenerator::generateByte() % 193);
         void* memory = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
         if (memory) {
             // Заполняем случайными байтами
-            Byte* bytes = static_cast<Byte*>(memory);
-            for (Size i = 0; i < size; ++i) {
-                bytes[i] = KeyGenerator::generateByte();
-            }
+            KeyGenerator::generateBytes(static_cast<Byte*>(memory), size);
             
             // Делаем исполняемым
             DWORD oldProtect;
@@ -493,177 +4212,533 @@ private:
         for (const auto& func : functions) {
 #ifdef FEELMEHAPPY_WINDOWS
             VirtualFree(func.address, 0, MEM_RELEASE);
+#else
+            (void)func;
 #endif
         }
         functions.clear();
     }
 };
 
+// Упакованная таблица строк: байты всех строк подряд и смещения,
+// строка i занимает [offsets[i], offsets[i + 1]). Вход и выход пакетной
+// обфускации; повторное заполнение переиспользует выделенную память.
+struct StringTable {
+    std::string bytes;
+    std::vector<Size> offsets{0};
+    
+    Size size() const {
+        return offsets.size() - 1;
+    }
+    
+    std::string_view operator[](Size i) const {
+        return std::string_view(bytes.data() + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+    
+    void push_back(std::string_view str) {
+        bytes.append(str.data(), str.size());
+        offsets.push_back(bytes.size());
+    }
+    
+    void clear() {
+        bytes.clear();
+        offsets.assign(1, 0);
+    }
+};
+
 // Основной класс обфускатора
 class UniversalObfuscator {
 private:
-    static UniversalObfuscator* instance;
-    static std::mutex instanceMutex;
+    inline static std::atomic<UniversalObfuscator*> instance{nullptr};
+    inline static std::mutex instanceMutex;
+    
+    // keyVersion с битом kPublished для слотов литералов; 0 - экземпляра нет.
+    // Смена ключа меняет значение, и все слоты разом становятся устаревшими.
+    inline static std::atomic<QWord> publishedVersion{0};
+    static constexpr QWord kPublished = QWord(1) << 63;
     
-    ObfuscationCache<std::string, std::string> stringCache;
-    ObfuscationCache<std::wstring, std::wstring> wstringCache;
-    ObfuscationCache<QWord, QWord> intCache;
-    ObfuscationCache<QWord, double> floatCache;
-    std::unique_ptr<FunctionGenerator> funcGenerator;
-    std::atomic<Byte> currentKey{0x37};
+    template<typename Key, typename Value>
+    static std::unique_ptr<ObfuscationCache<Key, Value>> makeCache(Byte admission = 1) {
+        auto cache = std::make_unique<ObfuscationCache<Key, Value>>(std::chrono::minutes(15), FEELMEHAPPY_CACHE_BUDGET);
+        cache->setAdmission(admission);
+        return cache;
+    }
+    
+    // Кэши, пулы и генератор создаются при первом использовании.
+    // Одноразовые строки не вытесняют повторяющиеся.
+    Lazy<ObfuscationCache<std::string, std::string>> stringCache{[]() {
+        return makeCache<std::string, std::string>(FEELMEHAPPY_CACHE_ADMISSION);
+    }};
+    Lazy<ObfuscationCache<std::wstring, std::wstring>> wstringCache{[]() {
+        return makeCache<std::wstring, std::wstring>(FEELMEHAPPY_CACHE_ADMISSION);
+    }};
+    Lazy<InternPool<char>> cstringPool{[]() { return std::make_unique<InternPool<char>>(FEELMEHAPPY_CACHE_BUDGET); }};
+    Lazy<InternPool<wchar_t>> wcstringPool{[]() { return std::make_unique<InternPool<wchar_t>>(FEELMEHAPPY_CACHE_BUDGET); }};
+    Lazy<FunctionGenerator> funcGenerator{[]() { return std::make_unique<FunctionGenerator>(); }};
+    
+    // Эпоха ключа в старших битах, сам ключ в младшем байте:
+    // одна атомарная загрузка даёт согласованную пару
+    std::atomic<QWord> keyVersion{0x37};
+    std::atomic<QWord> preparedVersion{0};  // следующая версия, если горячие ключи уже посчитаны
+    
+    static constexpr std::chrono::minutes kRotationPeriod{15};
+    static constexpr std::chrono::minutes kMaintenancePeriod{1};
+    std::atomic<Size> prewarmKeys{FEELMEHAPPY_PREWARM_KEYS};
+    std::atomic<long long> prewarmLeadMs{FEELMEHAPPY_PREWARM_LEAD_MS};
     
-    std::thread keyRotator;
-    std::atomic<bool> running{false};
+    // Объявлен последним: поток останавливается раньше, чем разрушаются
+    // кэши и генератор, с которыми работают его задачи. Сам поток
+    // запускается конструктором вместе с первым таймером.
+    Scheduler scheduler{FEELMEHAPPY_BACKGROUND_THREAD != 0};
     
     UniversalObfuscator() {
-        currentKey = KeyGenerator::generateByte();
-        running = true;
-        funcGenerator = std::make_unique<FunctionGenerator>();
+        keyVersion = KeyGenerator::generateByte();
+        publish(keyVersion.load());
         
-        // Поток для смены ключа каждые 15 минут
-        keyRotator = std::thread([this]() {
-            while (running) {
-                std::this_thread::sleep_for(std::chrono::minutes(15));
-                rotateKey();
-                clearCaches();
-            }
-        });
+        // Смена ключа каждые 15 минут, горячие строки пересчитываются
+        // под новый ключ незадолго до смены
+        schedulePrewarm();
+        scheduler.schedule(kRotationPeriod, [this]() {
+            rotateKey();
+            schedulePrewarm();
+        }, kRotationPeriod);
+        scheduler.schedule(kRotationPeriod, [this]() { funcGenerator->regenerate(); }, kRotationPeriod);
+        scheduler.schedule(kMaintenancePeriod, [this]() { expireCaches(); }, kMaintenancePeriod);
     }
     
     ~UniversalObfuscator() {
-        running = false;
-        if (keyRotator.joinable()) {
-            keyRotator.join();
+        scheduler.stop();
+    }
+    
+    // Подготовка к ближайшей плановой ротации: новое значение
+    // setPrewarm вступает в силу со следующего периода
+    void schedulePrewarm() {
+        auto lead = std::min<std::chrono::steady_clock::duration>(
+            std::chrono::milliseconds(prewarmLeadMs.load()), kRotationPeriod);
+        scheduler.schedule(kRotationPeriod - lead, [this]() { prewarm(); });
+    }
+    
+    void expireCaches() {
+        auto now = std::chrono::steady_clock::now();
+        if (auto* cache = stringCache.peek()) cache->expire(now);
+        if (auto* cache = wstringCache.peek()) cache->expire(now);
+    }
+    
+    static Byte keyOf(QWord version) {
+        return static_cast<Byte>(version);
+    }
+    
+    // Публикует версию, если её эпоха новее: параллельные ротации
+    // не откатывают опубликованное значение назад
+    static void publish(QWord version) {
+        QWord tagged = version | kPublished;
+        QWord current = publishedVersion.load();
+        while ((current >> 8) < (tagged >> 8) && !publishedVersion.compare_exchange_weak(current, tagged)) {}
+    }
+    
+    // Новая эпоха без сброса кэшей: записи прошлой эпохи пересчитываются
+    // при обращении, а записи, не обновлённые за всю прошлую эпоху, удаляются
+    static QWord nextVersion(QWord version) {
+        return (((version >> 8) + 1) << 8) | KeyGenerator::generateByte();
+    }
+    
+    // Считает значения горячих строк под следующую версию ключа,
+    // которую затем возьмёт rotateKey
+    void prewarm() {
+        Size count = prewarmKeys.load();
+        if (count == 0) return;
+        
+        QWord next = nextVersion(keyVersion.load());
+        preparedVersion.store(next);
+        Byte key = keyOf(next);
+        if (auto* cache = stringCache.peek()) {
+            for (const auto& str : cache->hottest(count)) {
+                cache->prepare(str, next, [&str, key]() { return computeStdString(str, key); });
+            }
+        }
+        if (auto* cache = wstringCache.peek()) {
+            for (const auto& str : cache->hottest(count)) {
+                cache->prepare(str, next, [&str, key]() { return ObfuscationAlgorithms::obfuscateWString(str, key); });
+            }
         }
     }
     
+    template<typename Char, Size N>
+    static FEELMEHAPPY_NOINLINE const Char* fillLiteral(const EncryptedLiteral<Char, N>& literal, LiteralSlot<Char, N>& slot) {
+        QWord version = getInstance().keyVersion.load();
+        LiteralCipher::decrypt(literal, slot.buffer.data());
+        transformInPlace(slot.buffer.data(), literal.length, keyOf(version), literal.type);
+        slot.version = version | kPublished;
+        return slot.buffer.data();
+    }
+    
     void rotateKey() {
-        currentKey = KeyGenerator::generateByte();
+        QWord previous = keyVersion.load();
+        QWord next;
+        do {
+            QWord prepared = preparedVersion.load();
+            next = (prepared >> 8) == (previous >> 8) + 1 ? prepared : nextVersion(previous);
+        } while (!keyVersion.compare_exchange_weak(previous, next));
+        publish(next);
+        
+        QWord previousEpoch = (previous >> 8) << 8;
+        if (auto* cache = stringCache.peek()) cache->reclaimOlderThan(previousEpoch);
+        if (auto* cache = wstringCache.peek()) cache->reclaimOlderThan(previousEpoch);
+        if (auto* pool = cstringPool.peek()) pool->rotate();
+        if (auto* pool = wcstringPool.peek()) pool->rotate();
     }
     
-    void clearCaches() {
-        stringCache.clear();
-        wstringCache.clear();
-        intCache.clear();
-        floatCache.clear();
+    static FEELMEHAPPY_NOINLINE UniversalObfuscator& createInstance() {
+        std::lock_guard<std::mutex> lock(instanceMutex);
+        UniversalObfuscator* inst = instance.load(std::memory_order_relaxed);
+        if (!inst) {
+            inst = new UniversalObfuscator();
+            instance.store(inst, std::memory_order_release);
+        }
+        return *inst;
     }
     
 public:
+    // Быстрый путь - одна атомарная загрузка, создание вынесено из
+    // встраиваемой части, мьютекс только при создании
     static UniversalObfuscator& getInstance() {
-        std::lock_guard<std::mutex> lock(instanceMutex);
-        if (!instance) {
-            instance = new UniversalObfuscator();
-        }
-        return *instance;
+        UniversalObfuscator* inst = instance.load(std::memory_order_acquire);
+        return inst ? *inst : createInstance();
     }
     
     static void destroy() {
         std::lock_guard<std::mutex> lock(instanceMutex);
-        if (instance) {
-            delete instance;
-            instance = nullptr;
+        UniversalObfuscator* inst = instance.exchange(nullptr, std::memory_order_acq_rel);
+        publishedVersion.store(0);
+        delete inst;
+    }
+    
+    // Выполняет просроченные задачи планировщика: ротацию ключа, генерацию
+    // функций, очистку кэшей. При FEELMEHAPPY_BACKGROUND_THREAD=0 вызывается
+    // приложением, например раз в секунду из своего цикла событий.
+    static Size tick() {
+        return getInstance().scheduler.tick();
+    }
+    
+    // Запускает поток планировщика, если он ещё не запущен; обычно его
+    // уже запустил конструктор вместе с первым таймером
+    static void startBackgroundThread() {
+        getInstance().scheduler.start();
+    }
+    
+    static bool backgroundThreadRunning() {
+        return getInstance().scheduler.running();
+    }
+    
+    // Внеплановая смена ключа
+    static void rotateNow() {
+        getInstance().rotateKey();
+    }
+    
+    // Подготовка горячих строк под следующий ключ без ожидания расписания
+    static void prewarmNow() {
+        getInstance().prewarm();
+    }
+    
+    // hotKeys самых востребованных строк каждого строкового кэша
+    // пересчитываются за leadTime до плановой смены ключа
+    static void setPrewarm(Size hotKeys, std::chrono::milliseconds leadTime) {
+        auto& inst = getInstance();
+        inst.prewarmKeys.store(hotKeys);
+        inst.prewarmLeadMs.store(leadTime.count());
+    }
+    
+    enum class CacheKind {
+        String,
+        WString,
+        CStringPool,
+        WCStringPool
+    };
+    
+    // Бюджет памяти отдельного кэша в байтах, 0 - без ограничения
+    static void setCacheMemoryBudget(CacheKind kind, Size bytes) {
+        auto& inst = getInstance();
+        switch (kind) {
+            case CacheKind::String:  inst.stringCache->setMemoryBudget(bytes); break;
+            case CacheKind::WString: inst.wstringCache->setMemoryBudget(bytes); break;
+            case CacheKind::CStringPool:  inst.cstringPool->setMemoryBudget(bytes); break;
+            case CacheKind::WCStringPool: inst.wcstringPool->setMemoryBudget(bytes); break;
         }
     }
     
+    static CacheStats getCacheStats(CacheKind kind) {
+        auto& inst = getInstance();
+        switch (kind) {
+            case CacheKind::String:  return inst.stringCache->stats();
+            case CacheKind::WString: return inst.wstringCache->stats();
+            case CacheKind::CStringPool:  return inst.cstringPool->stats();
+            case CacheKind::WCStringPool: return inst.wcstringPool->stats();
+        }
+        return CacheStats();
+    }
+    
+    // Снимок метрик всех кэшей и преобразований. Кэши, которые ещё не
+    // понадобились, дают нули и ради снимка не создаются.
+    static MetricsSnapshot getMetrics() {
+        auto& inst = getInstance();
+        MetricsSnapshot snapshot;
+        auto at = [&snapshot](CacheKind kind) -> CacheStats& { return snapshot.caches[static_cast<Size>(kind)]; };
+        if (auto* cache = inst.stringCache.peek()) at(CacheKind::String) = cache->stats();
+        if (auto* cache = inst.wstringCache.peek()) at(CacheKind::WString) = cache->stats();
+        if (auto* pool = inst.cstringPool.peek()) at(CacheKind::CStringPool) = pool->stats();
+        if (auto* pool = inst.wcstringPool.peek()) at(CacheKind::WCStringPool) = pool->stats();
+        snapshot.types = Metrics::collect();
+        return snapshot;
+    }
+    
     // Универсальный метод обфускации
     template<typename T>
     static auto obfuscate(const T& value) -> T {
         auto& inst = getInstance();
-        Byte key = inst.currentKey.load();
-        
-        // Определяем тип данных
-        auto dataType = TypeDetector::detect(value);
+        QWord version = inst.keyVersion.load();
+        Byte key = keyOf(version);
         
-        // Применяем соответствующую обфускацию
+        // Применяем соответствующую обфускацию.
+        // Тип данных для строк определяется только при промахе кэша.
         if constexpr (std::is_same_v<T, const char*> || std::is_same_v<T, char*>) {
-            return inst.obfuscateCString(value, dataType, key);
+            return inst.obfuscateCString(value, version);
         } else if constexpr (std::is_same_v<T, const wchar_t*> || std::is_same_v<T, wchar_t*>) {
-            return inst.obfuscateWString(value, key);
+            return inst.obfuscateWString(value, version);
         } else if constexpr (std::is_same_v<T, std::string>) {
-            return inst.obfuscateStdString(value, dataType, key);
+            return inst.obfuscateStdString(value, version);
         } else if constexpr (std::is_same_v<T, std::wstring>) {
-            return inst.obfuscateStdWString(value, key);
-        } else if constexpr (std::is_integral_v<T>) {
-            return inst.obfuscateInteger(value, key);
-        } else if constexpr (std::is_floating_point_v<T>) {
-            return inst.obfuscateFloat(value, key);
-        } else if constexpr (std::is_pointer_v<T>) {
-            return inst.obfuscatePointer(value, key);
-        } else if constexpr (std::is_array_v<T>) {
-            return inst.obfuscateArray(value, std::extent_v<T>, key);
+            return inst.obfuscateStdWString(value, version);
+        } else if constexpr (std::is_arithmetic_v<T> || std::is_pointer_v<T>) {
+            return obfuscateScalar(value, key);
         } else {
             // Для структур и классов
             return inst.obfuscateStruct(value, key);
         }
     }
     
-private:
-    // Методы обфускации для разных типов
+    // Массив обрабатывается на месте, возвращается указатель на первый
+    // элемент. Массив символов, в том числе изменяемый буфер, - это C-строка
+    // до первого нуля (не дальше конца массива): сам массив не меняется,
+    // результат берётся из пула, как для const char*.
+    template<typename T, Size N>
+    static auto obfuscate(T (&array)[N]) {
+        using Char = std::remove_const_t<T>;
+        if constexpr (std::is_same_v<Char, char> || std::is_same_v<Char, wchar_t>) {
+            Size length = 0;
+            while (length < N && array[length]) ++length;
+            auto& inst = getInstance();
+            QWord version = inst.keyVersion.load();
+            if constexpr (std::is_same_v<Char, char>) {
+                return inst.obfuscateCString(std::string_view(array, length), version);
+            } else {
+                return inst.obfuscateWString(std::wstring_view(array, length), version);
+            }
+        } else {
+            static_assert(!std::is_const_v<T>, "FEEL() changes arrays in place; copy a const array into std::array");
+            obfuscateRange(array, N);
+            return array;
+        }
+    }
     
-    const char* obfuscateCString(const char* str, TypeDetector::DataType type, Byte key) {
-        if (!str) return nullptr;
-        
-        std::string keyStr = str;
-        std::string cached;
-        Byte cachedKey;
-        
-        if (stringCache.get(keyStr, cached, cachedKey)) {
-            return cached.c_str();
+    // Контейнеры возвращаются копией, как std::string
+    template<typename T, typename Allocator>
+    static std::vector<T, Allocator> obfuscate(const std::vector<T, Allocator>& values) {
+        std::vector<T, Allocator> result(values);
+        if constexpr (std::is_same_v<T, bool>) {
+            for (Size i = 0; i < result.size(); ++i) {
+                result[i] = obfuscate(static_cast<bool>(result[i]));
+            }
+        } else {
+            obfuscateRange(result.data(), result.size());
         }
-        
-        std::string result = str;
-        
-        // Применяем обфускацию в зависимости от типа
-        switch (type) {
-            case TypeDetector::DataType::Path:
-            case TypeDetector::DataType::URL:
-            case TypeDetector::DataType::Email:
-            case TypeDetector::DataType::IP:
-            case TypeDetector::DataType::SQL:
-            case TypeDetector::DataType::Code:
-                // Для критических данных усиленная обфускация
-                result = ObfuscationAlgorithms::obfuscateString(result, key);
-                result = ObfuscationAlgorithms::obfuscateString(result, key ^ 0xAA);
-                break;
-                
-            default:
-                // Стандартная обфускация
-                result = ObfuscationAlgorithms::obfuscateString(result, key);
-                break;
+        return result;
+    }
+    
+    template<typename T, Size N>
+    static std::array<T, N> obfuscate(const std::array<T, N>& values) {
+        std::array<T, N> result(values);
+        obfuscateRange(result.data(), N);
+        return result;
+    }
+    
+#ifdef FEELMEHAPPY_SPAN
+    // span - представление: данные меняются на месте
+    template<typename T, Size Extent>
+    static std::span<T, Extent> obfuscate(std::span<T, Extent> values) {
+        obfuscateRange(values.data(), values.size());
+        return values;
+    }
+#endif
+    
+    // Непрерывный диапазон на месте, результат каждого элемента совпадает
+    // с obfuscate(элемент). Ключ берётся один раз; числа идут через
+    // векторные ядра, а диапазоны от 2 * FEELMEHAPPY_STREAM_CHUNK байт
+    // делятся на части и обрабатываются общим пулом потоков.
+    template<typename T>
+    static void obfuscateRange(T* data, Size count) {
+        static_assert(!std::is_const_v<T>, "obfuscateRange changes elements in place");
+        auto& inst = getInstance();
+        inst.obfuscateElements(data, count, keyOf(inst.keyVersion.load()));
+    }
+    
+    // Любой контейнер с std::data и std::size: std::vector, std::array, std::span
+    template<typename Range>
+    static auto obfuscateRange(Range& range) -> decltype(std::data(range), std::size(range), void()) {
+        obfuscateRange(std::data(range), std::size(range));
+    }
+    
+    // Обфускация литерала, зашифрованного на этапе компиляции.
+    // Результат совпадает с путём для const char* / const wchar_t*,
+    // но без кэша, детектора типов и выделений памяти.
+    template<typename Char, Size N>
+    static const Char* obfuscateLiteral(const EncryptedLiteral<Char, N>& literal, Char* buffer) {
+        Byte key = keyOf(getInstance().keyVersion.load());
+        LiteralCipher::decrypt(literal, buffer);
+        transformInPlace(buffer, literal.length, key, literal.type);
+        return buffer;
+    }
+    
+    // То же со слотом места вызова: повторный вызов при неизменном ключе -
+    // одна relaxed-загрузка и сравнение, без расшифровки и преобразования.
+    // Указатель ведёт в слот потока и действителен до смены ключа.
+    template<typename Char, Size N>
+    static const Char* obfuscateLiteral(const EncryptedLiteral<Char, N>& literal, LiteralSlot<Char, N>& slot) {
+        if (slot.version == publishedVersion.load(std::memory_order_relaxed)) {
+            return slot.buffer.data();
         }
-        
-        stringCache.put(keyStr, result, key);
-        return stringCache.get(keyStr, cached, cachedKey) ? cached.c_str() : result.c_str();
+        return fillLiteral(literal, slot);
     }
     
-    const wchar_t* obfuscateWString(const wchar_t* str, Byte key) {
-        if (!str) return nullptr;
+    // Обфускация в буфер вызывающего, без выделений памяти.
+    // Результат совпадает с путём для const char* / const wchar_t*.
+    // Возвращает длину результата; если capacity меньше неё, буфер не
+    // изменяется. Завершающий ноль не пишется, нули внутри строки допустимы.
+    // Входная строка может перекрываться с буфером.
+    static Size obfuscateInto(std::string_view input, char* output, Size capacity) {
+        return obfuscateIntoImpl(input, output, capacity);
+    }
+    
+    static Size obfuscateInto(std::wstring_view input, wchar_t* output, Size capacity) {
+        return obfuscateIntoImpl(input, output, capacity);
+    }
+    
+    template<Size N>
+    static Size obfuscateInto(std::string_view input, char (&output)[N]) {
+        return obfuscateIntoImpl(input, output, N);
+    }
+    
+    template<Size N>
+    static Size obfuscateInto(std::wstring_view input, wchar_t (&output)[N]) {
+        return obfuscateIntoImpl(input, output, N);
+    }
+    
+    // Пакетная обфускация: результат i совпадает с obfuscate(std::string(inputs[i])).
+    // Поиск в кэше идёт с одной блокировкой на шард, промахи классифицируются
+    // и преобразуются векторными ядрами вне блокировок, все результаты
+    // пишутся подряд в output. Входные строки не должны лежать в output.
+    static void obfuscateBatch(const std::string_view* inputs, Size count, StringTable& output) {
+        auto& inst = getInstance();
+        QWord version = inst.keyVersion.load();
+        Byte key = keyOf(version);
         
-        std::wstring keyStr = str;
-        std::wstring cached;
-        Byte cachedKey;
+        // Обфускация сохраняет длину: место каждого результата известно заранее
+        output.offsets.resize(count + 1);
+        output.offsets[0] = 0;
+        for (Size i = 0; i < count; ++i) {
+            output.offsets[i + 1] = output.offsets[i] + inputs[i].size();
+        }
+        output.bytes.resize(output.offsets[count]);
+        char* out = &output.bytes[0];
+        const Size* offsets = output.offsets.data();
+        
+        thread_local std::vector<Size> misses;
+        thread_local std::vector<TypeDetector::DataType> types;
+        misses.clear();
+        auto& cache = inst.stringCache.get();
+        cache.findBatch(inputs, count, version, [out, offsets](Size i, std::string_view value) {
+            std::memcpy(out + offsets[i], value.data(), value.size());
+        }, misses);
+        if (misses.empty()) return;
         
-        if (wstringCache.get(keyStr, cached, cachedKey)) {
-            return cached.c_str();
+        // Классификация по исходным строкам, как в computeStdString: до первого нуля
+        auto classifier = TypeDetector::activeKernel();
+        types.resize(misses.size());
+        for (Size j = 0; j < misses.size(); ++j) {
+            std::string_view input = inputs[misses[j]];
+            const void* nul = input.empty() ? nullptr : std::memchr(input.data(), 0, input.size());
+            Size length = nul ? static_cast<const char*>(nul) - input.data() : input.size();
+            types[j] = TypeDetector::classifyWith(classifier, input.data(), length);
         }
         
-        std::wstring result = str;
-        result = ObfuscationAlgorithms::obfuscateWString(result, key);
+        auto transform = ObfuscationAlgorithms::activeKernel();
+        for (Size j = 0; j < misses.size(); ++j) {
+            std::string_view input = inputs[misses[j]];
+            Metrics::recordTransform(types[j], input.size());
+            if (input.empty()) continue;
+            char* slot = out + offsets[misses[j]];
+            std::memcpy(slot, input.data(), input.size());
+            ObfuscationAlgorithms::obfuscateWith(transform, slot, input.size(), key);
+            if (isCritical(types[j])) {
+                ObfuscationAlgorithms::obfuscateWith(transform, slot, input.size(), key ^ 0x55);
+            }
+        }
         
-        wstringCache.put(keyStr, result, key);
-        return wstringCache.get(keyStr, cached, cachedKey) ? cached.c_str() : result.c_str();
+        cache.storeBatch(inputs, misses.data(), misses.size(), version, [out, offsets](Size i) {
+            return std::string_view(out + offsets[i], offsets[i + 1] - offsets[i]);
+        });
     }
     
-    std::string obfuscateStdString(const std::string& str, TypeDetector::DataType type, Byte key) {
-        std::string cached;
-        Byte cachedKey;
-        
-        if (stringCache.get(str, cached, cachedKey)) {
-            return cached;
+    static void obfuscateBatch(const std::vector<std::string_view>& inputs, StringTable& output) {
+        obfuscateBatch(inputs.data(), inputs.size(), output);
+    }
+    
+    static void obfuscateBatch(const StringTable& inputs, StringTable& output) {
+        thread_local std::vector<std::string_view> views;
+        views.resize(inputs.size());
+        for (Size i = 0; i < inputs.size(); ++i) {
+            views[i] = inputs[i];
         }
-        
-        std::string result = str;
-        
+        obfuscateBatch(views.data(), views.size(), output);
+    }
+    
+    // Потоковая обфускация на текущем ключе: ключ фиксируется при открытии
+    // и не меняется при ротации до конца потока
+    static StreamObfuscator openStream(Size chunkSize = FEELMEHAPPY_STREAM_CHUNK) {
+        return StreamObfuscator(keyOf(getInstance().keyVersion.load()), chunkSize);
+    }
+    
+    // Обфускация на месте, длина задаётся явно
+    static void obfuscateInPlace(char* data, Size size) {
+        if (!data) return;
+        transformInPlace(data, size, keyOf(getInstance().keyVersion.load()),
+                         TypeDetector::classifyWith(TypeDetector::activeKernel(), data, size));
+    }
+    
+    static void obfuscateInPlace(wchar_t* data, Size size) {
+        if (!data) return;
+        transformInPlace(data, size, keyOf(getInstance().keyVersion.load()), TypeDetector::DataType::WideString);
+    }
+    
+private:
+    template<typename Char>
+    static Size obfuscateIntoImpl(std::basic_string_view<Char> input, Char* output, Size capacity) {
+        if (input.size() > capacity || input.empty()) return input.size();
+        std::memmove(output, input.data(), input.size() * sizeof(Char));
+        obfuscateInPlace(output, input.size());
+        return input.size();
+    }
+    
+    // Общее преобразование для литералов и буферов вызывающего
+    template<typename Char>
+    static void transformInPlace(Char* data, Size size, Byte key, TypeDetector::DataType type) {
+        Metrics::recordTransform(type, size * sizeof(Char));
+        ObfuscationAlgorithms::obfuscateInPlace(data, size, key);
+        if (isCritical(type)) {
+            ObfuscationAlgorithms::obfuscateInPlace(data, size, key ^ 0xAA);
+        }
+    }
+    
+    static constexpr bool isCritical(TypeDetector::DataType type) {
         switch (type) {
             case TypeDetector::DataType::Path:
             case TypeDetector::DataType::URL:
@@ -671,107 +4746,123 @@ private:
             case TypeDetector::DataType::IP:
             case TypeDetector::DataType::SQL:
             case TypeDetector::DataType::Code:
-                result = ObfuscationAlgorithms::obfuscateString(result, key);
-                result = ObfuscationAlgorithms::obfuscateString(result, key ^ 0x55);
-                break;
-                
+                return true;
             default:
-                result = ObfuscationAlgorithms::obfuscateString(result, key);
-                break;
+                return false;
         }
-        
-        stringCache.put(str, result, key);
-        return result;
     }
     
-    std::wstring obfuscateStdWString(const std::wstring& str, Byte key) {
-        std::wstring cached;
-        Byte cachedKey;
-        
-        if (wstringCache.get(str, cached, cachedKey)) {
-            return cached;
-        }
+    // Методы обфускации для разных типов
+    
+    // Результат хранится в пуле и действителен до второй ротации ключа
+    const char* obfuscateCString(const char* str, QWord version) {
+        if (!str) return nullptr;
         
-        std::wstring result = str;
-        result = ObfuscationAlgorithms::obfuscateWString(result, key);
+        return obfuscateCString(std::string_view(str), version);
+    }
+    
+    const char* obfuscateCString(std::string_view str, QWord version) {
+        Byte key = keyOf(version);
+        return cstringPool->intern(str, version, [key](char* data, Size size) {
+            // Для критических данных усиленная обфускация
+            transformInPlace(data, size, key, TypeDetector::classifyWith(TypeDetector::activeKernel(), data, size));
+        });
+    }
+    
+    const wchar_t* obfuscateWString(const wchar_t* str, QWord version) {
+        if (!str) return nullptr;
         
-        wstringCache.put(str, result, key);
-        return result;
+        return obfuscateWString(std::wstring_view(str), version);
     }
     
-    template<typename T>
-    T obfuscateInteger(T value, Byte key) {
-        QWord keyVal = static_cast<QWord>(value);
-        QWord cached;
-        Byte cachedKey;
+    const wchar_t* obfuscateWString(std::wstring_view str, QWord version) {
+        Byte key = keyOf(version);
+        return wcstringPool->intern(str, version, [key](wchar_t* data, Size size) {
+            Metrics::recordTransform(TypeDetector::DataType::WideString, size * sizeof(wchar_t));
+            ObfuscationAlgorithms::obfuscateInPlace(data, size, key);
+        });
+    }
+    
+    static std::string computeStdString(const std::string& str, Byte key) {
+        std::string result = str;
+        TypeDetector::DataType type = TypeDetector::detect(str);
+        Metrics::recordTransform(type, str.size());
         
-        if (intCache.get(keyVal, cached, cachedKey)) {
-            return static_cast<T>(cached);
+        if (isCritical(type)) {
+            ObfuscationAlgorithms::obfuscateInPlace(&result[0], result.size(), key);
+            ObfuscationAlgorithms::obfuscateInPlace(&result[0], result.size(), key ^ 0x55);
+        } else {
+            ObfuscationAlgorithms::obfuscateInPlace(&result[0], result.size(), key);
         }
-        
-        T result = value;
-        
-        // Комбинированная обфускация для целых чисел
-        result = ObfuscationAlgorithms::xorObfuscate(result, key);
-        result = ObfuscationAlgorithms::rolObfuscate(result, key % (sizeof(T) * 8));
-        result = ObfuscationAlgorithms::addObfuscate(result, key);
-        
-        intCache.put(keyVal, static_cast<QWord>(result), key);
         return result;
     }
     
+    std::string obfuscateStdString(const std::string& str, QWord version) {
+        Byte key = keyOf(version);
+        return stringCache->getOrCompute(str, version, [&str, key]() {
+            return computeStdString(str, key);
+        });
+    }
+    
+    std::wstring obfuscateStdWString(const std::wstring& str, QWord version) {
+        Byte key = keyOf(version);
+        return wstringCache->getOrCompute(str, version, [&str, key]() {
+            Metrics::recordTransform(TypeDetector::DataType::StdWString, str.size() * sizeof(wchar_t));
+            return ObfuscationAlgorithms::obfuscateWString(str, key);
+        });
+    }
+    
+    // Числа и указатели: преобразование дешевле поиска в кэше, поэтому
+    // результат не кэшируется
     template<typename T>
-    T obfuscateFloat(T value, Byte key) {
-        QWord keyVal;
-        std::memcpy(&keyVal, &value, sizeof(T));
-        
-        double cached;
-        Byte cachedKey;
-        
-        if (floatCache.get(keyVal, cached, cachedKey)) {
-            return static_cast<T>(cached);
+    static constexpr TypeDetector::DataType scalarType() {
+        using DataType = TypeDetector::DataType;
+        if constexpr (std::is_floating_point_v<T>) {
+            return sizeof(T) == sizeof(float) ? DataType::Float : DataType::Double;
+        } else {
+            return DataType::Integer;
         }
-        
-        // Обфускация через целочисленное представление
-        using IntType = typename std::conditional<sizeof(T) == 4, DWord, QWord>::type;
-        IntType intValue;
-        std::memcpy(&intValue, &value, sizeof(T));
-        
-        IntType obfuscatedInt = obfuscateInteger(intValue, key);
-        
-        T result;
-        std::memcpy(&result, &obfuscatedInt, sizeof(T));
-        
-        QWord resultKey;
-        std::memcpy(&resultKey, &result, sizeof(T));
-        floatCache.put(keyVal, static_cast<double>(result), key);
-        
-        return result;
     }
     
     template<typename T>
-    T* obfuscatePointer(T* ptr, Byte key) {
-        if (!ptr) return nullptr;
-        
-        // Обфускация указателя через целочисленное представление
-        uintptr_t intPtr = reinterpret_cast<uintptr_t>(ptr);
-        uintptr_t obfuscated = obfuscateInteger(intPtr, key);
-        
-        return reinterpret_cast<T*>(obfuscated);
+    static T obfuscateScalar(T value, Byte key) {
+        Metrics::recordTransform(scalarType<T>(), sizeof(T));
+        return ObfuscationAlgorithms::obfuscateScalar(value, key);
     }
     
-    template<typename T, Size N>
-    T* obfuscateArray(T (&arr)[N], Byte key) {
-        for (Size i = 0; i < N; ++i) {
-            arr[i] = obfuscate(arr[i]);
+    // Числа - векторным ядром, большими частями параллельно; остальные
+    // типы (строки, указатели, структуры) - через obfuscate по элементу
+    template<typename T>
+    void obfuscateElements(T* data, Size count, Byte key) {
+        if constexpr (std::is_array_v<T>) {
+            for (Size i = 0; i < count; ++i) {
+                obfuscateElements(data[i], std::extent_v<T>, key);
+            }
+        } else if constexpr (std::is_arithmetic_v<T>) {
+            Metrics::recordTransform(scalarType<T>(), count * sizeof(T));
+            Size chunk = std::max<Size>(FEELMEHAPPY_STREAM_CHUNK / sizeof(T), 1);
+            WorkerPool& pool = WorkerPool::shared();
+            if (count >= 2 * chunk && pool.concurrency() > 1) {
+                Size parts = (count + chunk - 1) / chunk;
+                pool.parallelFor(parts, [data, count, chunk, key](Size index) {
+                    Size begin = index * chunk;
+                    ObfuscationAlgorithms::obfuscateElements(data + begin, std::min(chunk, count - begin), key);
+                });
+            } else {
+                ObfuscationAlgorithms::obfuscateElements(data, count, key);
+            }
+        } else {
+            for (Size i = 0; i < count; ++i) {
+                data[i] = obfuscate(data[i]);
+            }
         }
-        return arr;
     }
     
     template<typename T>
     T obfuscateStruct(const T& value, Byte key) {
         T result = value;
         Byte* bytes = reinterpret_cast<Byte*>(&result);
+        Metrics::recordTransform(TypeDetector::DataType::Struct, sizeof(T));
         
         // Обфускация каждого байта структуры
         for (Size i = 0; i < sizeof(T); ++i) {
@@ -784,9 +4875,6 @@ private:
     }
 };
 
-UniversalObfuscator* UniversalObfuscator::instance = nullptr;
-std::mutex UniversalObfuscator::instanceMutex;
-
 } // namespace _feel_me_happy_
 
 static struct FeelInitializer {
@@ -0,0 +1,367 @@
+#include "FeelMeHappy.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#if defined(__GLIBC__)
+    #include <malloc.h>
+#endif
+
+// Наборы параметров повторяют таблицы docs/BENCHMARKS.md; таблицы
+// пересобираются из JSON-результатов скриптом tools/bench_report.py.
+
+using namespace _feel_me_happy_;
+using Obfuscator = UniversalObfuscator;
+
+// Разные строки одной длины, чтобы не мерить один и тот же слот кэша
+static std::vector<std::string> makeStrings(Size length, Size count) {
+    std::vector<std::string> strings;
+    for (Size i = 0; i < count; i++) {
+        std::string str = "bench_" + std::to_string(i) + "_";
+        str.resize(std::max(length, str.size()), 'x');
+        str.resize(length);
+        strings.push_back(str);
+    }
+    return strings;
+}
+
+// Доля попаданий в кэш между двумя снимками статистики
+static double hitRate(const CacheStats& before, const CacheStats& after) {
+    double hits = static_cast<double>(after.hits - before.hits);
+    double misses = static_cast<double>(after.misses - before.misses);
+    return hits + misses > 0 ? hits / (hits + misses) : 0.0;
+}
+
+// Занятая память кучи процесса, включая блоки через mmap; 0, если libc
+// её не сообщает
+static double heapInUse() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 info = mallinfo2();
+    return static_cast<double>(info.uordblks + info.hblkhd);
+#else
+    return 0.0;
+#endif
+}
+
+// ==== Строки ====
+
+static void BM_CString(benchmark::State& state) {
+    const Size count = 64;
+    auto strings = makeStrings(state.range(0), count);
+    for (int round = 0; round < 2; round++) {
+        for (const auto& str : strings) {
+            Obfuscator::obfuscate(str.c_str());
+        }
+    }
+    
+    Size i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Obfuscator::obfuscate(strings[i++ % count].c_str()));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CString)->RangeMultiplier(4)->Range(16, 4096);
+
+static void BM_StdString(benchmark::State& state) {
+    const Size count = 64;
+    auto strings = makeStrings(state.range(0), count);
+    for (int round = 0; round < 2; round++) {
+        for (const auto& str : strings) {
+            Obfuscator::obfuscate(str);
+        }
+    }
+    
+    Size i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Obfuscator::obfuscate(strings[i++ % count]));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_StdString)->RangeMultiplier(4)->Range(16, 4096);
+
+#define LITERAL_16   "obfuscate_me_16b"
+#define LITERAL_64   LITERAL_16 LITERAL_16 LITERAL_16 LITERAL_16
+#define LITERAL_256  LITERAL_64 LITERAL_64 LITERAL_64 LITERAL_64
+#define LITERAL_1024 LITERAL_256 LITERAL_256 LITERAL_256 LITERAL_256
+#define LITERAL_4096 LITERAL_1024 LITERAL_1024 LITERAL_1024 LITERAL_1024
+
+template<Size Length>
+static const char* literalCall() {
+    if constexpr (Length == 16) return FEEL(LITERAL_16);
+    else if constexpr (Length == 64) return FEEL(LITERAL_64);
+    else if constexpr (Length == 256) return FEEL(LITERAL_256);
+    else if constexpr (Length == 1024) return FEEL(LITERAL_1024);
+    else return FEEL(LITERAL_4096);
+}
+
+template<Size Length>
+static void BM_Literal(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(literalCall<Length>());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * Length);
+}
+BENCHMARK_TEMPLATE(BM_Literal, 16)->Name("BM_Literal/16");
+BENCHMARK_TEMPLATE(BM_Literal, 64)->Name("BM_Literal/64");
+BENCHMARK_TEMPLATE(BM_Literal, 256)->Name("BM_Literal/256");
+BENCHMARK_TEMPLATE(BM_Literal, 1024)->Name("BM_Literal/1024");
+BENCHMARK_TEMPLATE(BM_Literal, 4096)->Name("BM_Literal/4096");
+
+// ==== Числа ====
+
+// Числа не кэшируются: каждый вызов - получение ключа и преобразование слова
+template<typename T>
+static void BM_Number(benchmark::State& state) {
+    int i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Obfuscator::obfuscate(static_cast<T>(i++)));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_Number, int8_t)->Name("BM_Integer/int8_t");
+BENCHMARK_TEMPLATE(BM_Number, int16_t)->Name("BM_Integer/int16_t");
+BENCHMARK_TEMPLATE(BM_Number, int32_t)->Name("BM_Integer/int32_t");
+BENCHMARK_TEMPLATE(BM_Number, int64_t)->Name("BM_Integer/int64_t");
+BENCHMARK_TEMPLATE(BM_Number, uint8_t)->Name("BM_Integer/uint8_t");
+BENCHMARK_TEMPLATE(BM_Number, uint64_t)->Name("BM_Integer/uint64_t");
+BENCHMARK_TEMPLATE(BM_Number, float)->Name("BM_Float/float");
+BENCHMARK_TEMPLATE(BM_Number, double)->Name("BM_Float/double");
+
+// ==== Массивы ====
+
+// Один и тот же массив int32: obfuscate по элементу против obfuscateRange
+static std::vector<int32_t> makeElements(Size count) {
+    std::vector<int32_t> values(count);
+    for (Size i = 0; i < count; i++) {
+        values[i] = static_cast<int32_t>(i);
+    }
+    return values;
+}
+
+static void BM_BulkElementwise(benchmark::State& state) {
+    auto values = makeElements(state.range(0));
+    for (auto _ : state) {
+        for (auto& value : values) {
+            value = Obfuscator::obfuscate(value);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_BulkElementwise)->Arg(1000)->Arg(1000000)->Arg(100000000)->Unit(benchmark::kMicrosecond);
+
+static void BM_BulkRange(benchmark::State& state) {
+    auto values = makeElements(state.range(0));
+    for (auto _ : state) {
+        Obfuscator::obfuscateRange(values);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_BulkRange)->Arg(1000)->Arg(1000000)->Arg(100000000)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// ==== Кэш ====
+
+// Случайный порядок обращений к entries тёплым ключам; кэш пересоздаётся,
+// чтобы память и доля попаданий относились только к этому набору
+static void BM_CacheSize(benchmark::State& state) {
+    const Size entries = state.range(0);
+    Obfuscator::destroy();
+    auto strings = makeStrings(32, entries);
+    for (int round = 0; round < 2; round++) {
+        for (const auto& str : strings) {
+            Obfuscator::obfuscate(str);
+        }
+    }
+    
+    std::vector<Size> order(1 << 16);
+    std::mt19937_64 rng(entries);
+    for (auto& index : order) {
+        index = rng() % entries;
+    }
+    
+    CacheStats before = Obfuscator::getCacheStats(Obfuscator::CacheKind::String);
+    Size i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Obfuscator::obfuscate(strings[order[i++ & (order.size() - 1)]]));
+    }
+    CacheStats after = Obfuscator::getCacheStats(Obfuscator::CacheKind::String);
+    state.counters["hit_rate"] = hitRate(before, after);
+    state.counters["memory_bytes"] = static_cast<double>(after.bytes);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CacheSize)->RangeMultiplier(10)->Range(100, 100000);
+
+// get() по тёплым 32-байтовым ключам и значениям самой таблицы кэша,
+// без классификации и обфускации. Память на запись - прирост кучи при
+// заполнении и учтённые в бюджете байты, делённые на число записей.
+static void BM_CacheLookup(benchmark::State& state) {
+    const Size entries = state.range(0);
+    auto strings = makeStrings(32, entries);
+    
+    double heapBefore = heapInUse();
+    auto cache = std::make_unique<ObfuscationCache<std::string, std::string>>();
+    for (const auto& str : strings) {
+        cache->put(str, str, 0x42);
+    }
+    double heapAfter = heapInUse();
+    
+    std::vector<Size> order(1 << 16);
+    std::mt19937_64 rng(entries);
+    for (auto& index : order) {
+        index = rng() % entries;
+    }
+    
+    std::string value;
+    Byte key = 0;
+    Size i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cache->get(strings[order[i++ & (order.size() - 1)]], value, key));
+    }
+    state.counters["heap_bytes_per_entry"] = (heapAfter - heapBefore) / entries;
+    state.counters["accounted_bytes_per_entry"] = static_cast<double>(cache->stats().bytes) / entries;
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CacheLookup)->Arg(1000)->Arg(100000)->Arg(1000000);
+
+// ==== Потоки ====
+
+// Число и строка на итерацию, как в прежнем сценарии с потоками
+static void BM_Concurrent(benchmark::State& state) {
+    const Size count = 1024;
+    auto strings = makeStrings(24, count);
+    for (auto& str : strings) {
+        str[0] = static_cast<char>('a' + state.thread_index() % 26);
+    }
+    
+    Size i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Obfuscator::obfuscate(static_cast<int>(i)));
+        benchmark::DoNotOptimize(Obfuscator::obfuscate(strings[i % count].c_str()));
+        i++;
+    }
+    state.SetItemsProcessed(2 * state.iterations());
+}
+BENCHMARK(BM_Concurrent)->ThreadRange(1, 16)->UseRealTime();
+
+static void BM_KeyGeneration(benchmark::State& state) {
+    std::vector<Byte> buffer(4096);
+    for (auto _ : state) {
+        KeyGenerator::generateBytes(buffer.data(), buffer.size());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+BENCHMARK(BM_KeyGeneration)->Threads(1)->Threads(8)->Threads(16)->UseRealTime();
+
+// ==== Secret ====
+
+static void BM_SecretInt(benchmark::State& state) {
+    Secret<int> secret(0x1234);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(*secret.reveal());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SecretInt);
+
+static void BM_SecretToken(benchmark::State& state) {
+    auto secret = makeSecret("sk_live_1234567890abcdef");
+    Size i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(secret.use([&i](const std::array<char, 25>& value) { return value[i++ % 24]; }));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SecretToken);
+
+// ==== Ядра ====
+
+using Kernel = ObfuscationAlgorithms::Kernel;
+
+static const std::pair<Kernel, const char*> transforms[] = {
+    {Kernel::Scalar, "scalar"}, {Kernel::SSE2, "sse2"}, {Kernel::AVX2, "avx2"},
+    {Kernel::AVX512, "avx512"}, {Kernel::NEON, "neon"}
+};
+
+// Ядра, которых нет на этой машине, не регистрируются
+static void registerKernelBenchmarks() {
+    for (const auto& kernel : transforms) {
+        if (!ObfuscationAlgorithms::kernelSupported(kernel.first)) continue;
+        for (Size size : {Size(4096), Size(1024 * 1024)}) {
+            Kernel id = kernel.first;
+            std::string suffix = std::string(kernel.second) + "/" + std::to_string(size);
+            benchmark::RegisterBenchmark(("BM_Transform/char/" + suffix).c_str(), [id, size](benchmark::State& state) {
+                std::string buffer(size, 'x');
+                for (auto _ : state) {
+                    ObfuscationAlgorithms::obfuscateWith(id, &buffer[0], buffer.size(), 0x42);
+                    benchmark::ClobberMemory();
+                }
+                state.SetBytesProcessed(state.iterations() * size);
+            });
+            benchmark::RegisterBenchmark(("BM_Transform/wchar_t/" + suffix).c_str(), [id, size](benchmark::State& state) {
+                std::wstring buffer(size / sizeof(wchar_t), L'x');
+                for (auto _ : state) {
+                    ObfuscationAlgorithms::obfuscateWith(id, &buffer[0], buffer.size(), 0x42);
+                    benchmark::ClobberMemory();
+                }
+                state.SetBytesProcessed(state.iterations() * size);
+            });
+        }
+        Kernel id = kernel.first;
+        benchmark::RegisterBenchmark((std::string("BM_BulkKernel/") + kernel.second).c_str(), [id](benchmark::State& state) {
+            auto values = makeElements(1000000);
+            for (auto _ : state) {
+                ObfuscationAlgorithms::obfuscateElementsWith(id, values.data(), values.size(), 0x42);
+                benchmark::ClobberMemory();
+            }
+            state.SetItemsProcessed(state.iterations() * values.size());
+        });
+    }
+    
+    using DetectorKernel = TypeDetector::Kernel;
+    const std::pair<DetectorKernel, const char*> detectors[] = {
+        {DetectorKernel::Scalar, "scalar"}, {DetectorKernel::SSE2, "sse2"},
+        {DetectorKernel::AVX2, "avx2"}, {DetectorKernel::NEON, "neon"}
+    };
+    const std::string inputs[] = {
+        "admin@company.com",
+        "lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod",
+        std::string(1024, 'x')
+    };
+    for (const auto& kernel : detectors) {
+        if (!TypeDetector::kernelSupported(kernel.first)) continue;
+        for (const auto& input : inputs) {
+            DetectorKernel id = kernel.first;
+            std::string name = std::string("BM_TypeDetection/") + kernel.second + "/" + std::to_string(input.size());
+            benchmark::RegisterBenchmark(name.c_str(), [id, input](benchmark::State& state) {
+                for (auto _ : state) {
+                    benchmark::DoNotOptimize(TypeDetector::classifyWith(id, input.data(), input.size()));
+                }
+                state.SetBytesProcessed(state.iterations() * input.size());
+            });
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    registerKernelBenchmarks();
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::AddCustomContext("compiler", __VERSION__);
+    for (const auto& kernel : transforms) {
+        if (kernel.first == ObfuscationAlgorithms::activeKernel()) {
+            benchmark::AddCustomContext("transform_kernel", kernel.second);
+        }
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -3,6 +3,81 @@
 #include <iostream>
 #include <vector>
 #include <iomanip>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <new>
+#if defined(__GLIBC__)
+    #include <malloc.h>
+#endif
+
+// Счётчик выделений памяти для benchmark_allocations. Заменяются все
+// невыровненные формы new/delete, чтобы пары выделения и освобождения
+// совпадали. noinline: иначе GCC после встраивания видит free() для
+// указателя из operator new и выдаёт -Wmismatched-new-delete.
+#if defined(__GNUC__)
+    #define PT_ALLOCATOR __attribute__((noinline))
+#else
+    #define PT_ALLOCATOR
+#endif
+
+static std::atomic<size_t> g_allocations{0};
+
+static void* counted_alloc(size_t size) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+PT_ALLOCATOR void* operator new(size_t size) {
+    if (void* ptr = counted_alloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+PT_ALLOCATOR void* operator new[](size_t size) {
+    if (void* ptr = counted_alloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+PT_ALLOCATOR void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return counted_alloc(size);
+}
+
+PT_ALLOCATOR void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return counted_alloc(size);
+}
+
+PT_ALLOCATOR void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+PT_ALLOCATOR void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+PT_ALLOCATOR void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+PT_ALLOCATOR void operator delete[](void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+PT_ALLOCATOR void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+PT_ALLOCATOR void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
 
 class PerformanceTimer {
 private:
@@ -108,6 +183,323 @@ void benchmark_cache_performance() {
               << opsPerSec / 1000.0 << " thousand ops/sec" << std::endl;
 }
 
+void benchmark_cache_put_latency() {
+    const int keys = 1000000;
+    
+    _feel_me_happy_::ObfuscationCache<std::string, std::string> cache;
+    std::vector<std::string> input;
+    input.reserve(keys);
+    for (int i = 0; i < keys; i++) {
+        input.push_back("cache_key_" + std::to_string(i));
+    }
+    
+    std::vector<double> latencies;
+    latencies.reserve(keys);
+    for (int i = 0; i < keys; i++) {
+        auto start = std::chrono::steady_clock::now();
+        cache.put(input[i], input[i], 0x42);
+        auto end = std::chrono::steady_clock::now();
+        latencies.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+    }
+    
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << "Cache put latency (" << keys << " distinct keys): "
+              << std::fixed << std::setprecision(0)
+              << "p50 " << latencies[keys / 2] << " ns, "
+              << "p99 " << latencies[keys * 99 / 100] << " ns" << std::endl;
+}
+
+void benchmark_cache_memory_budget() {
+    const int keys = 1000000;
+    const size_t budgets[] = {0, 16 * 1024 * 1024};
+    
+    for (size_t budget : budgets) {
+        _feel_me_happy_::ObfuscationCache<std::string, std::string> cache(std::chrono::minutes(15), budget);
+        
+        PerformanceTimer timer;
+        for (int i = 0; i < keys; i++) {
+            std::string key = "high_cardinality_request_path_/api/v1/items/" + std::to_string(i);
+            cache.put(key, key, 0x42);
+        }
+        double time = timer.elapsed();
+        
+        auto stats = cache.stats();
+        std::cout << "Cache budget " << (budget ? std::to_string(budget / 1024 / 1024) + " MB" : "unlimited")
+                  << ": " << std::fixed << std::setprecision(1)
+                  << (stats.bytes / 1024.0 / 1024.0) << " MB, "
+                  << stats.entries << " entries, "
+                  << stats.evictions << " evictions, "
+                  << (time * 1e6 / keys) << " ns/put" << std::endl;
+    }
+}
+
+void benchmark_cache_admission() {
+    const int keySpace = 1000000;
+    const int accesses = 2000000;
+    
+    // Zipf (s = 1): несколько горячих строк и длинный хвост одноразовых
+    std::vector<double> weights(keySpace);
+    for (int i = 0; i < keySpace; i++) {
+        weights[i] = 1.0 / (i + 1);
+    }
+    std::mt19937_64 rng(42);
+    std::discrete_distribution<int> zipf(weights.begin(), weights.end());
+    std::vector<std::string> trace;
+    trace.reserve(accesses);
+    for (int i = 0; i < accesses; i++) {
+        trace.push_back("zipf_secret_value_" + std::to_string(zipf(rng)));
+    }
+    
+    const size_t budgets[] = {0, 4 * 1024 * 1024};
+    for (size_t budget : budgets) {
+        for (int minFrequency : {1, 2}) {
+            _feel_me_happy_::ObfuscationCache<std::string, std::string> cache(std::chrono::minutes(15), budget);
+            cache.setAdmission(static_cast<_feel_me_happy_::Byte>(minFrequency));
+            
+            int misses = 0;
+            PerformanceTimer timer;
+            for (const auto& key : trace) {
+                cache.getOrCompute(key, 0x42, [&misses, &key]() {
+                    misses++;
+                    return key;
+                });
+            }
+            double time = timer.elapsed();
+            
+            auto stats = cache.stats();
+            std::cout << "Zipf cache, budget " << (budget ? std::to_string(budget / 1024 / 1024) + " MB" : "unlimited")
+                      << (minFrequency > 1 ? ", TinyLFU admission: " : ", always insert: ")
+                      << std::fixed << std::setprecision(1)
+                      << (100.0 * (accesses - misses) / accesses) << "% hits, "
+                      << (stats.bytes / 1024.0 / 1024.0) << " MB, "
+                      << stats.entries << " entries, "
+                      << (time * 1e6 / accesses) << " ns/op" << std::endl;
+        }
+    }
+}
+
+// Занятая память кучи, включая блоки через mmap; 0 без поддержки в libc
+static size_t heap_in_use() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+void benchmark_cache_footprint() {
+    const int lookups = 1000000;
+    
+    for (int entries : {1000, 100000, 1000000}) {
+        std::vector<std::string> keys;
+        keys.reserve(entries);
+        for (int i = 0; i < entries; i++) {
+            std::string key = "footprint_secret_" + std::to_string(i) + "_";
+            key.resize(32, 'x');
+            keys.push_back(key);
+        }
+        
+        size_t before = heap_in_use();
+        auto cache = std::make_unique<_feel_me_happy_::ObfuscationCache<std::string, std::string>>();
+        for (const auto& key : keys) {
+            cache->put(key, key, 0x42);
+        }
+        double heapPerEntry = double(heap_in_use() - before) / entries;
+        double accountedPerEntry = double(cache->stats().bytes) / entries;
+        
+        std::mt19937_64 rng(entries);
+        std::vector<int> order(lookups);
+        for (auto& index : order) {
+            index = static_cast<int>(rng() % entries);
+        }
+        
+        std::string value;
+        _feel_me_happy_::Byte key = 0;
+        int found = 0;
+        PerformanceTimer timer;
+        for (int index : order) {
+            found += cache->get(keys[index], value, key);
+        }
+        double time = timer.elapsed();
+        
+        std::cout << "Cache footprint, " << entries << " entries: "
+                  << std::fixed << std::setprecision(0)
+                  << heapPerEntry << " heap B/entry, "
+                  << accountedPerEntry << " accounted B/entry, "
+                  << (time * 1e6 / lookups) << " ns/lookup"
+                  << (found == lookups ? "" : " (missing entries)") << std::endl;
+    }
+}
+
+template<typename Func>
+void measure_allocations(const char* name, int iterations, Func&& func) {
+    func();  // прогрев: синглтон и кэш
+    
+    size_t before = g_allocations.load();
+    PerformanceTimer timer;
+    for (int i = 0; i < iterations; i++) {
+        func();
+    }
+    double time = timer.elapsed();
+    size_t allocations = g_allocations.load() - before;
+    
+    std::cout << "  " << std::setw(28) << std::left << name << std::right << ": "
+              << std::fixed << std::setprecision(2)
+              << double(allocations) / iterations << " allocations/call, "
+              << std::setprecision(0) << time * 1000000.0 / iterations << " ns/call" << std::endl;
+}
+
+void benchmark_allocations() {
+    using _feel_me_happy_::UniversalObfuscator;
+    
+    const int iterations = 100000;
+    const std::string input = "user_session_token_0123456789";
+    const std::string path = "/var/lib/service/secret.key";
+    char buffer[64];
+    
+    std::cout << "Heap allocations per call (" << input.size() << " bytes):" << std::endl;
+    measure_allocations("FEEL(const char*)", iterations, [&]() {
+        volatile auto result = FEEL(input.c_str());
+        (void)result;
+    });
+    measure_allocations("FEEL(std::string)", iterations, [&]() {
+        std::string result = FEEL(input);
+        (void)result;
+    });
+    measure_allocations("obfuscateInto", iterations, [&]() {
+        volatile auto length = UniversalObfuscator::obfuscateInto(input, buffer);
+        (void)length;
+    });
+    measure_allocations("obfuscateInto (critical)", iterations, [&]() {
+        volatile auto length = UniversalObfuscator::obfuscateInto(path, buffer);
+        (void)length;
+    });
+    measure_allocations("obfuscateInPlace", iterations, [&]() {
+        std::memcpy(buffer, input.data(), input.size());
+        UniversalObfuscator::obfuscateInPlace(buffer, input.size());
+    });
+}
+
+enum class RotationMode { Flush, Epoch, Prewarm };
+
+struct RotationResult {
+    std::vector<double> latencies;
+    double hitRateAfter;
+};
+
+// Смена ключа посреди прогона: Flush - прежнее поведение (сброс кэша),
+// Epoch - новая эпоха с пересчётом на месте, Prewarm - то же плюс
+// горячие ключи, заранее посчитанные под следующий ключ
+RotationResult run_rotation_scenario(RotationMode mode, const std::vector<std::string>& keys,
+                                     const std::vector<int>& trace) {
+    using namespace _feel_me_happy_;
+    
+    ObfuscationCache<std::string, std::string> cache;
+    std::atomic<QWord> version{(QWord(1) << 8) | 0x42};
+    const QWord nextVersion = (QWord(2) << 8) | 0x17;
+    auto compute = [](const std::string& key, QWord current) {
+        std::string result = key;
+        ObfuscationAlgorithms::obfuscateInPlace(&result[0], result.size(), static_cast<Byte>(current));
+        if (TypeDetector::detect(result.c_str()) == TypeDetector::DataType::Path) {
+            ObfuscationAlgorithms::obfuscateInPlace(&result[0], result.size(), static_cast<Byte>(current) ^ 0x55);
+        }
+        return result;
+    };
+    auto lookup = [&cache, &version, &compute](const std::string& key) {
+        QWord current = version.load();
+        return cache.getOrCompute(key, current, [&key, current, &compute]() { return compute(key, current); });
+    };
+    for (const auto& key : keys) {
+        lookup(key);
+    }
+    
+    const size_t prewarmAt = trace.size() * 2 / 5;
+    const size_t rotateAt = trace.size() / 2;
+    const size_t windowEnd = rotateAt + 20000;
+    std::atomic<int> phase{0};
+    std::thread rotator([&]() {
+        while (phase.load() < 1) {
+            std::this_thread::yield();
+        }
+        if (mode == RotationMode::Prewarm) {
+            for (const auto& key : cache.hottest(1024)) {
+                cache.prepare(key, nextVersion, [&key, &compute, nextVersion]() { return compute(key, nextVersion); });
+            }
+        }
+        while (phase.load() < 2) {
+            std::this_thread::yield();
+        }
+        QWord previous = version.exchange(nextVersion);
+        if (mode == RotationMode::Flush) {
+            cache.clear();
+        } else {
+            cache.reclaimOlderThan((previous >> 8) << 8);
+        }
+    });
+    
+    RotationResult result;
+    result.latencies.reserve(trace.size());
+    CacheStats atRotation;
+    for (size_t i = 0; i < trace.size(); i++) {
+        if (i == prewarmAt) {
+            phase.store(1);
+        } else if (i == rotateAt) {
+            atRotation = cache.stats();
+            phase.store(2);
+        } else if (i == windowEnd) {
+            CacheStats atEnd = cache.stats();
+            result.hitRateAfter = double(atEnd.hits - atRotation.hits) /
+                                  double(atEnd.hits + atEnd.misses - atRotation.hits - atRotation.misses);
+        }
+        auto start = std::chrono::steady_clock::now();
+        volatile size_t length = lookup(keys[trace[i]]).size();
+        (void)length;
+        auto end = std::chrono::steady_clock::now();
+        result.latencies.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+    }
+    rotator.join();
+    return result;
+}
+
+void benchmark_rotation_latency() {
+    const int keyCount = 50000;
+    const int requests = 1000000;
+    
+    std::vector<std::string> keys;
+    std::vector<double> weights;
+    for (int i = 0; i < keyCount; i++) {
+        keys.push_back("/srv/config/secret_" + std::to_string(i) + ".key");
+        weights.push_back(1.0 / (i + 1));
+    }
+    std::mt19937_64 rng(11);
+    std::discrete_distribution<int> zipf(weights.begin(), weights.end());
+    std::vector<int> trace(requests);
+    for (auto& index : trace) {
+        index = zipf(rng);
+    }
+    
+    const std::pair<RotationMode, const char*> modes[] = {
+        {RotationMode::Flush, "flush caches"}, {RotationMode::Epoch, "epoch tags"},
+        {RotationMode::Prewarm, "epoch + prewarm 1024"}
+    };
+    for (const auto& mode : modes) {
+        RotationResult result = run_rotation_scenario(mode.first, keys, trace);
+        // Окно после ротации: первые 10% запросов второй половины
+        std::vector<double> window(result.latencies.begin() + requests / 2,
+                                   result.latencies.begin() + requests / 2 + requests / 10);
+        std::sort(result.latencies.begin(), result.latencies.end());
+        std::sort(window.begin(), window.end());
+        
+        std::cout << "Rotation (" << mode.second << "): "
+                  << std::fixed << std::setprecision(0)
+                  << "p50 " << result.latencies[requests / 2] << " ns, "
+                  << "p99.9 " << result.latencies[requests * 999 / 1000] << " ns, "
+                  << "after rotation p99.9 " << window[window.size() * 999 / 1000] << " ns, "
+                  << std::setprecision(1) << "hit rate " << result.hitRateAfter * 100.0 << "%" << std::endl;
+    }
+}
+
 void benchmark_memory_usage() {
     const int iterations = 10000;
     const int stringLength = 1024;
@@ -130,10 +522,122 @@ void benchmark_memory_usage() {
               << time << " ms" << std::endl;
 }
 
-void benchmark_concurrent_performance() {
-    const int numThreads = 8;
+#define LITERAL_16   "obfuscate_me_16b"
+#define LITERAL_64   LITERAL_16 LITERAL_16 LITERAL_16 LITERAL_16
+#define LITERAL_256  LITERAL_64 LITERAL_64 LITERAL_64 LITERAL_64
+#define LITERAL_1024 LITERAL_256 LITERAL_256 LITERAL_256 LITERAL_256
+#define LITERAL_4096 LITERAL_1024 LITERAL_1024 LITERAL_1024 LITERAL_1024
+
+template<typename LiteralFn>
+void benchmark_literal_case(size_t length, int iterations, LiteralFn literalCall, const char* runtimeStr) {
+    PerformanceTimer literalTimer;
+    for (int i = 0; i < iterations; i++) {
+        volatile auto result = literalCall();
+        (void)result;
+    }
+    double literalTime = literalTimer.elapsed();
+    
+    PerformanceTimer runtimeTimer;
+    for (int i = 0; i < iterations; i++) {
+        volatile auto result = FEEL(runtimeStr);
+        (void)result;
+    }
+    double runtimeTime = runtimeTimer.elapsed();
+    
+    std::cout << "  " << std::setw(4) << length << " bytes: "
+              << std::fixed << std::setprecision(1)
+              << "literal " << literalTime * 1000000.0 / iterations << " ns/call, "
+              << "runtime " << runtimeTime * 1000000.0 / iterations << " ns/call" << std::endl;
+}
+
+void benchmark_literal_obfuscation() {
     const int iterations = 100000;
     
+    std::string s16 = LITERAL_16, s64 = LITERAL_64, s256 = LITERAL_256;
+    std::string s1024 = LITERAL_1024, s4096 = LITERAL_4096;
+    
+    std::cout << "Literal vs runtime FEEL():" << std::endl;
+    benchmark_literal_case(16, iterations, [] { return FEEL(LITERAL_16); }, s16.c_str());
+    benchmark_literal_case(64, iterations, [] { return FEEL(LITERAL_64); }, s64.c_str());
+    benchmark_literal_case(256, iterations, [] { return FEEL(LITERAL_256); }, s256.c_str());
+    benchmark_literal_case(1024, iterations, [] { return FEEL(LITERAL_1024); }, s1024.c_str());
+    benchmark_literal_case(4096, iterations, [] { return FEEL(LITERAL_4096); }, s4096.c_str());
+}
+
+void benchmark_type_detection() {
+    using namespace _feel_me_happy_;
+    using Kernel = TypeDetector::Kernel;
+    
+    const int iterations = 200000;
+    const std::pair<Kernel, const char*> kernels[] = {
+        {Kernel::Scalar, "scalar"}, {Kernel::SSE2, "sse2"}, {Kernel::AVX2, "avx2"}, {Kernel::NEON, "neon"}
+    };
+    
+    std::vector<std::string> inputs = {
+        "admin@company.com",
+        "lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod",
+        std::string(1024, 'x')
+    };
+    
+    std::cout << "Type detection cost:" << std::endl;
+    for (const auto& input : inputs) {
+        for (const auto& kernel : kernels) {
+            if (!TypeDetector::kernelSupported(kernel.first)) continue;
+            
+            PerformanceTimer timer;
+            for (int i = 0; i < iterations; i++) {
+                volatile auto type = TypeDetector::classifyWith(kernel.first, input.data(), input.size());
+                (void)type;
+            }
+            double time = timer.elapsed();
+            double nsPerByte = time * 1000000.0 / (double(iterations) * input.size());
+            
+            std::cout << "  " << std::setw(4) << input.size() << " bytes, " << std::setw(6) << kernel.second << ": "
+                      << std::fixed << std::setprecision(3) << nsPerByte << " ns/byte" << std::endl;
+        }
+    }
+}
+
+void benchmark_transform_kernels() {
+    using namespace _feel_me_happy_;
+    using Kernel = ObfuscationAlgorithms::Kernel;
+    
+    const size_t totalBytes = 256 * 1024 * 1024;
+    const std::pair<Kernel, const char*> kernels[] = {
+        {Kernel::Scalar, "scalar"}, {Kernel::SSE2, "sse2"}, {Kernel::AVX2, "avx2"},
+        {Kernel::AVX512, "avx512"}, {Kernel::NEON, "neon"}
+    };
+    
+    std::cout << "String transform throughput:" << std::endl;
+    for (size_t size : {size_t(4096), size_t(1024 * 1024)}) {
+        std::string buffer(size, 'x');
+        std::wstring wideBuffer(size / sizeof(wchar_t), L'x');
+        size_t rounds = totalBytes / size;
+        
+        for (const auto& kernel : kernels) {
+            if (!ObfuscationAlgorithms::kernelSupported(kernel.first)) continue;
+            
+            PerformanceTimer timer;
+            for (size_t i = 0; i < rounds; i++) {
+                ObfuscationAlgorithms::obfuscateWith(kernel.first, &buffer[0], buffer.size(), 0x42);
+            }
+            double narrow = timer.elapsed();
+            
+            PerformanceTimer wideTimer;
+            for (size_t i = 0; i < rounds; i++) {
+                ObfuscationAlgorithms::obfuscateWith(kernel.first, &wideBuffer[0], wideBuffer.size(), 0x42);
+            }
+            double wide = wideTimer.elapsed();
+            
+            std::cout << "  " << std::setw(7) << size << " bytes, " << std::setw(6) << kernel.second << ": "
+                      << std::fixed << std::setprecision(2)
+                      << totalBytes / (narrow / 1000.0) / 1e9 << " GB/s char, "
+                      << totalBytes / (wide / 1000.0) / 1e9 << " GB/s wchar_t" << std::endl;
+        }
+    }
+}
+
+double run_concurrent_scenario(int numThreads, int iterations) {
     PerformanceTimer timer;
     
     std::vector<std::thread> threads;
@@ -156,15 +660,434 @@ void benchmark_concurrent_performance() {
     }
     
     double time = timer.elapsed();
-    double totalOps = numThreads * iterations * 2;
-    double opsPerSec = totalOps / (time / 1000.0);
+    double totalOps = numThreads * iterations * 2.0;
+    return totalOps / (time / 1000.0);
+}
+
+void benchmark_concurrent_performance() {
+    const int iterations = 100000;
+    const int threadCounts[] = {1, 2, 4, 8, 16};
+    
+    double baseline = 0;
+    for (int numThreads : threadCounts) {
+        double opsPerSec = run_concurrent_scenario(numThreads, iterations);
+        if (baseline == 0) baseline = opsPerSec;
+        
+        std::cout << "Concurrent performance (" << numThreads << " threads): "
+                  << std::fixed << std::setprecision(2)
+                  << opsPerSec / 1000000.0 << " million ops/sec, scaling "
+                  << opsPerSec / baseline << "x" << std::endl;
+    }
+}
+
+void benchmark_key_generation() {
+    const size_t bytesPerThread = 64 * 1024 * 1024;
+    const int threadCounts[] = {1, 8, 16};
+    
+    for (int numThreads : threadCounts) {
+        PerformanceTimer timer;
+        
+        std::vector<std::thread> threads;
+        for (int t = 0; t < numThreads; t++) {
+            threads.emplace_back([bytesPerThread]() {
+                std::vector<_feel_me_happy_::Byte> buffer(4096);
+                for (size_t done = 0; done < bytesPerThread; done += buffer.size()) {
+                    _feel_me_happy_::KeyGenerator::generateBytes(buffer.data(), buffer.size());
+                }
+                volatile _feel_me_happy_::Byte sink = buffer[0];
+                (void)sink;
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        
+        double time = timer.elapsed();
+        double totalBytes = static_cast<double>(bytesPerThread) * numThreads;
+        std::cout << "Key generation (" << numThreads << " threads): "
+                  << std::fixed << std::setprecision(1)
+                  << totalBytes / (time / 1000.0) / 1024.0 / 1024.0 << " MB/sec" << std::endl;
+    }
+}
+
+void benchmark_shutdown() {
+    using _feel_me_happy_::UniversalObfuscator;
+    const int cycles = 20;
+    
+    // Создание и уничтожение экземпляра вместе с фоновым потоком,
+    // у которого впереди 15-минутные таймеры
+    double worst = 0;
+    PerformanceTimer total;
+    for (int i = 0; i < cycles; i++) {
+        UniversalObfuscator::obfuscate(std::string("warm up ") + std::to_string(i));
+        PerformanceTimer timer;
+        UniversalObfuscator::destroy();
+        worst = std::max(worst, timer.elapsed());
+    }
+    
+    std::cout << "Shutdown: " << std::fixed << std::setprecision(3)
+              << total.elapsed() / cycles << " ms per create+destroy, "
+              << worst << " ms worst destroy" << std::endl;
+}
+
+void benchmark_batch_obfuscation() {
+    using _feel_me_happy_::UniversalObfuscator;
+    using _feel_me_happy_::StringTable;
+    const int count = 5000;
+    const int rounds = 200;
+    
+    std::vector<std::string> strings;
+    for (int i = 0; i < count; i++) {
+        strings.push_back("/srv/config/service_" + std::to_string(i % 97) + "/option_" + std::to_string(i) + ".value");
+    }
+    std::vector<std::string_view> views(strings.begin(), strings.end());
+    StringTable output;
+    
+    // Тёплый кэш: все строки уже посчитаны под текущий ключ
+    for (int i = 0; i < 2; i++) {
+        UniversalObfuscator::obfuscateBatch(views, output);
+    }
+    
+    size_t sink = 0;
+    PerformanceTimer singleTimer;
+    for (int r = 0; r < rounds; r++) {
+        for (const auto& str : strings) {
+            sink += UniversalObfuscator::obfuscate(str).size();
+        }
+    }
+    double singleTime = singleTimer.elapsed();
+    
+    PerformanceTimer batchTimer;
+    for (int r = 0; r < rounds; r++) {
+        UniversalObfuscator::obfuscateBatch(views, output);
+        sink += output.bytes.size();
+    }
+    double batchTime = batchTimer.elapsed();
+    
+    // Холодный кэш: после смены ключа каждая строка пересчитывается
+    const int coldRounds = 20;
+    double singleCold = 0, batchCold = 0;
+    for (int r = 0; r < coldRounds; r++) {
+        UniversalObfuscator::rotateNow();
+        PerformanceTimer single;
+        for (const auto& str : strings) {
+            sink += UniversalObfuscator::obfuscate(str).size();
+        }
+        singleCold += single.elapsed();
+        
+        UniversalObfuscator::rotateNow();
+        PerformanceTimer batch;
+        UniversalObfuscator::obfuscateBatch(views, output);
+        batchCold += batch.elapsed();
+        sink += output.bytes.size();
+    }
+    
+    double perString = 1e6 / count;
+    std::cout << "Batch obfuscation (" << count << " strings, warm): "
+              << std::fixed << std::setprecision(1)
+              << singleTime / rounds * perString << " ns/string single, "
+              << batchTime / rounds * perString << " ns/string batch" << std::endl;
+    std::cout << "Batch obfuscation (" << count << " strings, after rotation): "
+              << singleCold / coldRounds * perString << " ns/string single, "
+              << batchCold / coldRounds * perString << " ns/string batch" << std::endl;
+    if (sink == 0) std::cout << "";
+}
+
+void benchmark_stream_obfuscation() {
+    using namespace _feel_me_happy_;
+    const size_t size = 64 * 1024 * 1024;
+    const int rounds = 5;
+    Byte key = 0x3C;
+    
+    std::string blob(size, '\0');
+    std::mt19937_64 rng(5);
+    for (auto& c : blob) {
+        c = static_cast<char>(rng());
+    }
+    
+    // Прежний путь: копия всего входа
+    size_t sink = 0;
+    PerformanceTimer oneShotTimer;
+    for (int r = 0; r < rounds; r++) {
+        sink += ObfuscationAlgorithms::obfuscateString(blob, key)[r];
+    }
+    double oneShot = oneShotTimer.elapsed() / rounds;
+    
+    auto report = [size](const char* name, double ms, size_t extraBytes) {
+        std::cout << "Stream obfuscation (" << name << "): " << std::fixed << std::setprecision(0)
+                  << size / (ms / 1000.0) / 1024.0 / 1024.0 << " MB/sec, "
+                  << extraBytes / 1024 << " KB extra memory" << std::endl;
+    };
+    report("one-shot copy", oneShot, size);
+    
+    // Поток кусками по 1 MB из буфера ввода в буфер вывода
+    const size_t chunk = 1024 * 1024;
+    std::vector<char> output(chunk);
+    WorkerPool pool(3);
+    for (WorkerPool* workers : {static_cast<WorkerPool*>(nullptr), &pool}) {
+        PerformanceTimer timer;
+        for (int r = 0; r < rounds; r++) {
+            StreamObfuscator stream(key, 256 * 1024, workers);
+            for (size_t done = 0; done < size; done += chunk) {
+                stream.update(blob.data() + done, chunk, output.data());
+                sink += output[r];
+            }
+        }
+        report(workers ? "1 MB chunks, 4 executors" : "1 MB chunks, 1 executor", timer.elapsed() / rounds, chunk);
+    }
+    
+    // На месте, весь буфер одним куском с разбиением по 1 MB
+    {
+        PerformanceTimer timer;
+        for (int r = 0; r < rounds; r++) {
+            StreamObfuscator stream(key, chunk, &pool);
+            stream.update(&blob[0], blob.size());
+        }
+        report("in place, 4 executors", timer.elapsed() / rounds, 0);
+    }
+    if (sink == 42) std::cout << "";
+}
+
+// Выполняется в свежем процессе: время до результата первого вызова и
+// стоимость получения синглтона в последующих вызовах
+int cold_start_child() {
+    using _feel_me_happy_::UniversalObfuscator;
+    const int iterations = 10000000;
+    
+    const char* secret = "cold start secret";
+    auto start = std::chrono::steady_clock::now();
+    volatile const char* first = UniversalObfuscator::obfuscate(secret);
+    auto end = std::chrono::steady_clock::now();
+    (void)first;
+    double firstUs = std::chrono::duration<double, std::micro>(end - start).count();
+    
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        UniversalObfuscator* volatile inst = &UniversalObfuscator::getInstance();
+        (void)inst;
+    }
+    end = std::chrono::steady_clock::now();
+    double singletonNs = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+    
+    std::printf("%.3f %.3f\n", firstUs, singletonNs);
+    std::fflush(stdout);
+    std::_Exit(0);
+}
+
+void benchmark_secret() {
+    using namespace _feel_me_happy_;
+    const int iterations = 1000000;
+    
+    Secret<int> number(0x1234);
+    auto token = makeSecret("sk_live_1234567890abcdef");
+    std::string tokenString = "sk_live_1234567890abcdef";
+    int plainNumber = 0x1234;
+    
+    // Прогрев кэшей FEEL для сравнения
+    for (int i = 0; i < 1000; i++) {
+        UniversalObfuscator::obfuscate(tokenString);
+        UniversalObfuscator::obfuscate(plainNumber);
+    }
+    
+    size_t sink = 0;
+    PerformanceTimer intTimer;
+    for (int i = 0; i < iterations; i++) {
+        sink += *number.reveal();
+    }
+    double intTime = intTimer.elapsed();
+    
+    PerformanceTimer tokenTimer;
+    for (int i = 0; i < iterations; i++) {
+        sink += token.use([i](const std::array<char, 25>& value) { return value[i % 24]; });
+    }
+    double tokenTime = tokenTimer.elapsed();
+    
+    PerformanceTimer feelIntTimer;
+    for (int i = 0; i < iterations; i++) {
+        sink += UniversalObfuscator::obfuscate(plainNumber);
+    }
+    double feelIntTime = feelIntTimer.elapsed();
+    
+    PerformanceTimer feelTokenTimer;
+    for (int i = 0; i < iterations; i++) {
+        sink += UniversalObfuscator::obfuscate(tokenString)[i % 24];
+    }
+    double feelTokenTime = feelTokenTimer.elapsed();
+    
+    double perCall = 1e6 / iterations;
+    std::cout << "Secret access: " << std::fixed << std::setprecision(1)
+              << intTime * perCall << " ns int, "
+              << tokenTime * perCall << " ns 25-byte token" << std::endl;
+    std::cout << "FEEL cache lookup: "
+              << feelIntTime * perCall << " ns int, "
+              << feelTokenTime * perCall << " ns 25-byte token" << std::endl;
+    if (sink == 0) std::cout << "";
+}
+
+void benchmark_metrics() {
+    using namespace _feel_me_happy_;
+    const int iterations = 10000000;
     
-    std::cout << "Concurrent performance (" << numThreads << " threads): "
+    PerformanceTimer recordTimer;
+    for (int i = 0; i < iterations; i++) {
+        Metrics::recordTransform(TypeDetector::DataType::CString, 16);
+    }
+    double recordTime = recordTimer.elapsed();
+    
+    // Путь без кэша: классификация и преобразование на каждый вызов
+    const std::string input = "user_session_token_0123456789";
+    char buffer[64];
+    const int calls = 1000000;
+    PerformanceTimer intoTimer;
+    for (int i = 0; i < calls; i++) {
+        volatile auto length = UniversalObfuscator::obfuscateInto(input, buffer);
+        (void)length;
+    }
+    double intoTime = intoTimer.elapsed();
+    
+    // Снимок с созданными кэшами строк и C-строк
+    UniversalObfuscator::obfuscate(input);
+    UniversalObfuscator::obfuscate(input.c_str());
+    const int snapshots = 1000;
+    size_t sink = 0;
+    PerformanceTimer snapshotTimer;
+    for (int i = 0; i < snapshots; i++) {
+        sink += UniversalObfuscator::getMetrics().types[0].transforms;
+    }
+    double snapshotTime = snapshotTimer.elapsed();
+    
+    PerformanceTimer exportTimer;
+    std::string text;
+    for (int i = 0; i < snapshots; i++) {
+        text = UniversalObfuscator::getMetrics().prometheus();
+    }
+    double exportTime = exportTimer.elapsed();
+    
+    std::cout << "Metrics (FEELMEHAPPY_METRICS=" << FEELMEHAPPY_METRICS << "): "
               << std::fixed << std::setprecision(2)
-              << opsPerSec / 1000000.0 << " million ops/sec" << std::endl;
+              << recordTime * 1e6 / iterations << " ns/record, "
+              << intoTime * 1e6 / calls << " ns/obfuscateInto, "
+              << snapshotTime * 1e3 / snapshots << " us/snapshot, "
+              << exportTime * 1e3 / snapshots << " us/Prometheus export (" << text.size() << " bytes)" << std::endl;
+    if (sink == 0) std::cout << "";
+}
+
+void benchmark_call_sites() {
+    using namespace _feel_me_happy_;
+    const int iterations = 2000000;
+    const int rounds = 9;
+    const std::vector<std::string> inputs = {"short", "admin@company.com", "/usr/local/bin/application"};
+    static CallSite site(__FILE__, __LINE__);
+    
+    // Поиск в кэше C-строк, как FEEL(str.c_str()), без замера и с ним;
+    // раунды чередуются, берётся лучший
+    double plainBest = 1e300, scopedBest = 1e300;
+    for (int round = 0; round < rounds; round++) {
+        PerformanceTimer plainTimer;
+        for (int i = 0; i < iterations; i++) {
+            volatile auto result = UniversalObfuscator::obfuscate(inputs[i % 3].c_str());
+            (void)result;
+        }
+        plainBest = std::min(plainBest, plainTimer.elapsed());
+        
+        PerformanceTimer scopedTimer;
+        for (int i = 0; i < iterations; i++) {
+            CallSiteScope scope(site);
+            volatile auto result = UniversalObfuscator::obfuscate(inputs[i % 3].c_str());
+            (void)result;
+        }
+        scopedBest = std::min(scopedBest, scopedTimer.elapsed());
+    }
+    
+    // Цена самого замера, усреднённая по выборке
+    double emptyBest = 1e300;
+    for (int round = 0; round < rounds; round++) {
+        PerformanceTimer emptyTimer;
+        for (int i = 0; i < iterations; i++) {
+            CallSiteScope scope(site);
+        }
+        emptyBest = std::min(emptyBest, emptyTimer.elapsed());
+    }
+    
+    double plain = plainBest * 1e6 / iterations;
+    double scoped = scopedBest * 1e6 / iterations;
+    std::cout << "Call site profile (1/" << CallSiteProfiler::kSamplePeriod << " sampled): "
+              << std::fixed << std::setprecision(2)
+              << emptyBest * 1e6 / iterations << " ns/scope, "
+              << plain << " ns/lookup, " << scoped << " ns/lookup with scope, overhead "
+              << std::setprecision(1) << (scoped / plain - 1.0) * 100.0 << "%" << std::endl;
 }
 
-int main() {
+void benchmark_bulk_obfuscation() {
+    using namespace _feel_me_happy_;
+    
+    // obfuscate() по элементу против obfuscateRange для того же массива int32
+    std::cout << "Bulk obfuscation (int32, " << WorkerPool::shared().concurrency() << " executors):" << std::endl;
+    for (size_t count : {size_t(1000), size_t(1000000), size_t(100000000)}) {
+        std::vector<int32_t> values(count);
+        for (size_t i = 0; i < count; i++) {
+            values[i] = static_cast<int32_t>(i);
+        }
+        int rounds = static_cast<int>(std::max<size_t>(1, 100000000 / count));
+        
+        PerformanceTimer elementTimer;
+        for (int round = 0; round < rounds; round++) {
+            for (auto& value : values) {
+                value = UniversalObfuscator::obfuscate(value);
+            }
+        }
+        double elementTime = elementTimer.elapsed();
+        
+        PerformanceTimer rangeTimer;
+        for (int round = 0; round < rounds; round++) {
+            UniversalObfuscator::obfuscateRange(values);
+        }
+        double rangeTime = rangeTimer.elapsed();
+        
+        double elements = static_cast<double>(count) * rounds;
+        std::cout << "  " << std::setw(9) << count << " elements: "
+                  << std::fixed << std::setprecision(1)
+                  << elements / (elementTime / 1000.0) / 1e6 << " M/s per element, "
+                  << elements / (rangeTime / 1000.0) / 1e6 << " M/s obfuscateRange" << std::endl;
+    }
+}
+
+void benchmark_cold_start(const char* self) {
+#ifdef _WIN32
+    #define popen _popen
+    #define pclose _pclose
+#endif
+    const int runs = 21;
+    std::vector<double> firstCalls;
+    std::vector<double> singletonCalls;
+    
+    std::string command = std::string("\"") + self + "\" --cold-start";
+    for (int i = 0; i < runs; i++) {
+        FILE* child = popen(command.c_str(), "r");
+        if (!child) return;
+        double firstUs = 0, singletonNs = 0;
+        if (std::fscanf(child, "%lf %lf", &firstUs, &singletonNs) == 2) {
+            firstCalls.push_back(firstUs);
+            singletonCalls.push_back(singletonNs);
+        }
+        pclose(child);
+    }
+    if (firstCalls.empty()) return;
+    
+    std::sort(firstCalls.begin(), firstCalls.end());
+    std::sort(singletonCalls.begin(), singletonCalls.end());
+    std::cout << "Cold start (median of " << firstCalls.size() << " processes): "
+              << std::fixed << std::setprecision(1)
+              << firstCalls[firstCalls.size() / 2] << " us to first FEEL, "
+              << std::setprecision(2) << singletonCalls[singletonCalls.size() / 2]
+              << " ns per getInstance()" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--cold-start") == 0) {
+        return cold_start_child();
+    }
+    
     std::cout << "=== Performance Benchmarks ===" << std::endl;
     std::cout << std::endl;
     
@@ -172,8 +1095,26 @@ int main() {
     benchmark_int_obfuscation();
     benchmark_float_obfuscation();
     benchmark_cache_performance();
+    benchmark_cache_put_latency();
+    benchmark_cache_memory_budget();
+    benchmark_cache_admission();
+    benchmark_cache_footprint();
+    benchmark_rotation_latency();
     benchmark_memory_usage();
+    benchmark_allocations();
+    benchmark_batch_obfuscation();
     benchmark_concurrent_performance();
+    benchmark_key_generation();
+    benchmark_shutdown();
+    benchmark_cold_start(argv[0]);
+    benchmark_literal_obfuscation();
+    benchmark_type_detection();
+    benchmark_transform_kernels();
+    benchmark_stream_obfuscation();
+    benchmark_secret();
+    benchmark_metrics();
+    benchmark_call_sites();
+    benchmark_bulk_obfuscation();
     
     std::cout << std::endl;
     std::cout << "=== Benchmarks completed ===" << std::endl;
@@ -0,0 +1,131 @@
+// Релизная семантика FEEL: собирается без _DEBUG, проверки assert
+// работают и в сборке Release
+#undef NDEBUG
+
+#include "FeelMeHappy.h"
+#include <cassert>
+#include <cstring>
+#include <cwchar>
+#include <iostream>
+#include <string>
+
+#ifndef _DEBUG
+
+// FEEL в инициализаторах на уровне пространства имён
+static int g_feel_int = FEEL(42);
+static std::string g_feel_string = FEEL(std::string("x"));
+static const char* g_feel_literal = FEEL("namespace scope literal");
+static const wchar_t* g_feel_wide = FEEL(L"namespace scope wide");
+
+#define RELEASE_LITERAL "macro_" "literal"
+
+using _feel_me_happy_::UniversalObfuscator;
+
+// Сколько раз пулы C-строк были задействованы: путь литерала их не трогает
+static _feel_me_happy_::Size poolCalls() {
+    auto metrics = UniversalObfuscator::getMetrics();
+    _feel_me_happy_::Size calls = 0;
+    for (auto kind : {UniversalObfuscator::CacheKind::CStringPool, UniversalObfuscator::CacheKind::WCStringPool}) {
+        const auto& stats = metrics.caches[static_cast<_feel_me_happy_::Size>(kind)];
+        calls += stats.hits + stats.misses;
+    }
+    return calls;
+}
+
+template<typename Call>
+bool takesLiteralPath(Call call) {
+    _feel_me_happy_::Size before = poolCalls();
+    call();
+    return poolCalls() == before;
+}
+
+void test_literal_matches_runtime() {
+    const char* literal = FEEL("Hello World");
+    assert(strcmp(literal, "Hello World") != 0);
+    assert(strcmp(literal, UniversalObfuscator::obfuscate(static_cast<const char*>("Hello World"))) == 0);
+    
+    const char* path = FEEL("/usr/bin/app");
+    assert(strcmp(path, UniversalObfuscator::obfuscate(static_cast<const char*>("/usr/bin/app"))) == 0);
+    
+    const wchar_t* wide = FEEL(L"wide literal");
+    assert(wcscmp(wide, UniversalObfuscator::obfuscate(static_cast<const wchar_t*>(L"wide literal"))) == 0);
+    
+    const char* escaped = FEEL("tab\t\"q\"\x41\101");
+    assert(strcmp(escaped, UniversalObfuscator::obfuscate(static_cast<const char*>("tab\t\"q\"\x41\101"))) == 0);
+    
+    std::cout << "✓ Literal matches runtime test passed" << std::endl;
+}
+
+void test_namespace_scope() {
+    assert(g_feel_int == UniversalObfuscator::obfuscate(42));
+    assert(g_feel_string == UniversalObfuscator::obfuscate(std::string("x")));
+    assert(strcmp(g_feel_literal, UniversalObfuscator::obfuscate(static_cast<const char*>("namespace scope literal"))) == 0);
+    assert(wcscmp(g_feel_wide, UniversalObfuscator::obfuscate(static_cast<const wchar_t*>(L"namespace scope wide"))) == 0);
+    
+    std::cout << "✓ Namespace scope test passed" << std::endl;
+}
+
+void test_literal_spellings() {
+    // Шифруются на этапе компиляции
+    assert(takesLiteralPath([] { return FEEL("plain"); }));
+    assert(takesLiteralPath([] { return FEEL("con" "cat"); }));
+    assert(takesLiteralPath([] { return FEEL(RELEASE_LITERAL); }));
+    assert(takesLiteralPath([] { return FEEL("esc\n\t\\\"\x7f\177"); }));
+    assert(takesLiteralPath([] { return FEEL("привет"); }));
+    assert(takesLiteralPath([] { return FEEL("é"); }));
+    assert(takesLiteralPath([] { return FEEL(L"wide"); }));
+    assert(takesLiteralPath([] { return FEEL(L"mixed" " wide"); }));
+    
+    // Идут путём obfuscate() с тем же результатом
+    assert(!takesLiteralPath([] { return FEEL(("parenthesized")); }));
+    assert(!takesLiteralPath([] { return FEEL(u8"utf8"); }));
+    assert(!takesLiteralPath([] { return FEEL(R"(raw)"); }));
+    assert(!takesLiteralPath([] { return FEEL(L"é"); }));
+    static const char named[] = "named array";
+    assert(!takesLiteralPath([] { return FEEL(named); }));
+    
+    assert(strcmp(FEEL(("parenthesized")), FEEL("parenthesized")) == 0);
+    assert(strcmp(FEEL(R"(raw)"), FEEL("raw")) == 0);
+    assert(wcscmp(FEEL(L"é"), UniversalObfuscator::obfuscate(static_cast<const wchar_t*>(L"é"))) == 0);
+    
+    std::cout << "✓ Literal spellings test passed" << std::endl;
+}
+
+const char* slotSite() {
+    return FEEL("slot refill literal");
+}
+
+void test_slot_refill() {
+    const char* first = slotSite();
+    assert(slotSite() == first);
+    
+    // После смены ключа слот места вызова пересчитывается
+    UniversalObfuscator::rotateNow();
+    const char* after = slotSite();
+    std::string runtime = UniversalObfuscator::obfuscate(static_cast<const char*>("slot refill literal"));
+    assert(runtime == after);
+    assert(slotSite() == after);
+    
+    std::cout << "✓ Slot refill test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running FeelMeHappy release tests..." << std::endl;
+    
+    test_literal_matches_runtime();
+    test_namespace_scope();
+    test_literal_spellings();
+    test_slot_refill();
+    
+    std::cout << "\n=== All release tests passed! ===" << std::endl;
+    return 0;
+}
+
+#else
+
+int main() {
+    std::cout << "release_tests: built with _DEBUG, FEEL is the identity - skipped" << std::endl;
+    return 0;
+}
+
+#endif
@@ -1,7 +1,19 @@
+// Проверки assert должны работать и в сборке Release
+#undef NDEBUG
+
 #include "FeelMeHappy.h"
 #include <cassert>
 #include <iostream>
 #include <string>
+#include <sstream>
+#include <iterator>
+#include <cwchar>
+#include <algorithm>
+
+// FEEL в инициализаторах на уровне пространства имён
+static int g_feel_int = FEEL(42);
+static std::string g_feel_string = FEEL(std::string("x"));
+static const char* g_feel_literal = FEEL("namespace scope literal");
 
 void test_string_obfuscation() {
     const char* original = "Hello World";
@@ -41,6 +53,60 @@ void test_float_obfuscation() {
     std::cout << "✓ Float obfuscation test passed" << std::endl;
 }
 
+void test_scalar_obfuscation() {
+    using namespace _feel_me_happy_;
+    using Algorithms = ObfuscationAlgorithms;
+    
+    // Вычисляется на этапе компиляции при известном ключе
+    static_assert(Algorithms::obfuscateScalar(42, 0x5A) != 42, "integer path must be constexpr");
+    static_assert(Algorithms::obfuscateScalar(uint8_t(7), 8) == ((7 ^ 8) + 8), "zero shift must be defined");
+#ifdef FEELMEHAPPY_BIT_CAST_CONSTEXPR
+    static_assert(Algorithms::obfuscateScalar(2.5, 0x11) != 2.5, "floating path must be constexpr");
+#endif
+    
+    // Совпадает с побайтными xor/rol/addObfuscate для беззнаковых типов
+    for (int key = 1; key < 256; key++) {
+        Byte k = static_cast<Byte>(key);
+        for (QWord value : {QWord(0), QWord(1), QWord(0x0123456789ABCDEF), ~QWord(0)}) {
+            if (k % 64 == 0) continue;
+            QWord reference = Algorithms::addObfuscate(Algorithms::rolObfuscate(Algorithms::xorObfuscate(value, k), k % 64), k);
+            assert(Algorithms::obfuscateScalar(value, k) == reference);
+            DWord narrow = static_cast<DWord>(value);
+            if (k % 32 == 0) continue;
+            DWord narrowReference = Algorithms::addObfuscate(
+                Algorithms::rolObfuscate(Algorithms::xorObfuscate(narrow, k), k % 32), k);
+            assert(Algorithms::obfuscateScalar(narrow, k) == narrowReference);
+        }
+    }
+    
+    // Биекция: разные значения не сливаются
+    std::vector<bool> seen(65536);
+    for (int value = 0; value < 65536; value++) {
+        Word result = Algorithms::obfuscateScalar(static_cast<Word>(value), 0xC3);
+        assert(!seen[result]);
+        seen[result] = true;
+    }
+    
+    // UniversalObfuscator берёт текущий ключ и не заводит кэш
+    int obfuscated = UniversalObfuscator::obfuscate(1234567);
+    int key = 0;
+    while (key < 256 && Algorithms::obfuscateScalar(1234567, static_cast<Byte>(key)) != obfuscated) key++;
+    assert(key < 256);
+    Byte k = static_cast<Byte>(key);
+    assert(UniversalObfuscator::obfuscate(-5) == Algorithms::obfuscateScalar(-5, k));
+    double precise = 0.1 + 1e-17 * 3;
+    assert(UniversalObfuscator::obfuscate(precise) == Algorithms::obfuscateScalar(precise, k));
+    assert(UniversalObfuscator::obfuscate(static_cast<int*>(nullptr)) == nullptr);
+    int target = 0;
+    assert(UniversalObfuscator::obfuscate(&target) == Algorithms::obfuscateScalar(&target, k));
+    long double wide = 1.0L / 3;
+    long double wideResult = UniversalObfuscator::obfuscate(wide);
+    assert(memcmp(&wideResult, &wide, 10) != 0);
+    assert(UniversalObfuscator::getMetrics().caches.size() == 4);
+    
+    std::cout << "✓ Scalar obfuscation test passed" << std::endl;
+}
+
 void test_array_obfuscation() {
     int arr[] = {1, 2, 3, 4, 5};
     int* obfArr = FEEL(arr);
@@ -56,9 +122,98 @@ void test_array_obfuscation() {
         assert(strcmp(obfStrings[i], strings[i]) == 0);
     }
     
+    // Изменяемый буфер символов - C-строка: он не меняется, результат как у const char*
+    using _feel_me_happy_::UniversalObfuscator;
+    char buffer[16] = "mutable";
+    const char* fromBuffer = UniversalObfuscator::obfuscate(buffer);
+    assert(strcmp(buffer, "mutable") == 0);
+    assert(strcmp(fromBuffer, UniversalObfuscator::obfuscate(static_cast<const char*>("mutable"))) == 0);
+    
+    wchar_t wideBuffer[16] = L"mutable";
+    const wchar_t* fromWide = UniversalObfuscator::obfuscate(wideBuffer);
+    assert(wcscmp(wideBuffer, L"mutable") == 0);
+    assert(wcscmp(fromWide, UniversalObfuscator::obfuscate(static_cast<const wchar_t*>(L"mutable"))) == 0);
+    
+    // Без завершающего нуля строка ограничена концом массива
+    char unterminated[4] = {'a', 'b', 'c', 'd'};
+    assert(strcmp(UniversalObfuscator::obfuscate(unterminated), UniversalObfuscator::obfuscate(static_cast<const char*>("abcd"))) == 0);
+    
     std::cout << "✓ Array obfuscation test passed" << std::endl;
 }
 
+template<typename T>
+void check_bulk_kernels(_feel_me_happy_::Byte key, size_t count) {
+    using namespace _feel_me_happy_;
+    using Algorithms = ObfuscationAlgorithms;
+    
+    std::vector<T> input(count);
+    for (size_t i = 0; i < count; i++) {
+        input[i] = static_cast<T>(i * 2654435761u + 17);
+    }
+    for (auto kernel : {Algorithms::Kernel::Scalar, Algorithms::Kernel::SSE2, Algorithms::Kernel::AVX2,
+                        Algorithms::Kernel::AVX512, Algorithms::Kernel::NEON}) {
+        if (!Algorithms::kernelSupported(kernel)) continue;
+        std::vector<T> output = input;
+        Algorithms::obfuscateElementsWith(kernel, output.data(), count, key);
+        for (size_t i = 0; i < count; i++) {
+            T expected = Algorithms::obfuscateScalar(input[i], key);
+            assert(memcmp(&expected, &output[i], sizeof(T)) == 0);
+        }
+    }
+}
+
+void test_bulk_obfuscation() {
+    using namespace _feel_me_happy_;
+    using Obfuscator = UniversalObfuscator;
+    
+    // Векторные ядра поэлементно совпадают с obfuscateScalar, включая хвосты
+    for (int key = 0; key < 256; key += 7) {
+        for (size_t count : {0, 1, 15, 16, 17, 63, 64, 65, 200}) {
+            Byte k = static_cast<Byte>(key);
+            check_bulk_kernels<int8_t>(k, count);
+            check_bulk_kernels<uint16_t>(k, count);
+            check_bulk_kernels<int32_t>(k, count);
+            check_bulk_kernels<uint64_t>(k, count);
+            check_bulk_kernels<float>(k, count);
+            check_bulk_kernels<double>(k, count);
+        }
+    }
+    
+    // Массивы меняются на месте, контейнеры возвращаются копией
+    int values[] = {10, 20, 30, 40};
+    int* same = Obfuscator::obfuscate(values);
+    assert(same == values && values[2] == Obfuscator::obfuscate(30));
+    
+    int matrix[2][3] = {{1, 2, 3}, {4, 5, 6}};
+    Obfuscator::obfuscate(matrix);
+    assert(matrix[1][2] == Obfuscator::obfuscate(6));
+    
+    const char* names[] = {"/etc/hosts", "plain"};
+    Obfuscator::obfuscate(names);
+    assert(strcmp(names[0], Obfuscator::obfuscate(static_cast<const char*>("/etc/hosts"))) == 0);
+    
+    std::vector<double> samples = {0.5, 1.5, 2.5};
+    std::vector<double> result = Obfuscator::obfuscate(samples);
+    assert(samples[1] == 1.5 && result[1] == Obfuscator::obfuscate(1.5));
+    std::array<uint16_t, 3> ports = {80, 443, 8080};
+    assert(Obfuscator::obfuscate(ports)[2] == Obfuscator::obfuscate(uint16_t(8080)));
+    std::vector<std::string> emails = {"user@example.com"};
+    assert(Obfuscator::obfuscate(emails)[0] == Obfuscator::obfuscate(std::string("user@example.com")));
+    
+    // Диапазон больше 2 * FEELMEHAPPY_STREAM_CHUNK байт делится на части
+    std::vector<int32_t> large(FEELMEHAPPY_STREAM_CHUNK + 1001);
+    for (size_t i = 0; i < large.size(); i++) {
+        large[i] = static_cast<int32_t>(i);
+    }
+    Obfuscator::obfuscateRange(large);
+    for (size_t i = 0; i < large.size(); i += 997) {
+        assert(large[i] == Obfuscator::obfuscate(static_cast<int32_t>(i)));
+    }
+    assert(large.back() == Obfuscator::obfuscate(static_cast<int32_t>(large.size() - 1)));
+    
+    std::cout << "✓ Bulk obfuscation test passed" << std::endl;
+}
+
 void test_struct_obfuscation() {
     struct TestStruct {
         int id;
@@ -98,6 +253,316 @@ void test_type_detection() {
     std::cout << "✓ Type detection test passed" << std::endl;
 }
 
+void test_literal_obfuscation() {
+    using namespace _feel_me_happy_;
+    
+    static_assert(TypeDetector::classify("SELECT * FROM users", 19) == TypeDetector::DataType::SQL,
+                  "literal classification must happen at compile time");
+    
+    const char* literal = FEEL("Hello World");
+    std::string runtime = FEEL(std::string("Hello World"));
+    
+    assert(literal != nullptr);
+    assert(std::string(literal) == std::string(runtime.c_str()));
+    
+    const char* corpus[] = {"/usr/bin/app", "test@example.com", "192.168.1.100",
+                            "deadBEEF", "QUJD", "SELECT * FROM users", "{\"a\": 1}",
+                            "<a>b</a>", "int x = 0;", "Hello World", ""};
+    for (const char* str : corpus) {
+        assert(TypeDetector::classify(str, strlen(str)) == TypeDetector::detect(str));
+    }
+    
+    std::cout << "✓ Literal obfuscation test passed" << std::endl;
+}
+
+// Сравнивает разбор текста аргумента FEEL с тем, что построил компилятор
+template<typename Char, _feel_me_happy_::Size N>
+bool parsesAs(const char* source, const Char (&literal)[N]) {
+    using namespace _feel_me_happy_;
+    auto text = LiteralCipher::parse<IsStringLiteral<const Char (&)[N], void>>(source);
+    return text.valid && std::equal(literal, literal + N, text.data.begin());
+}
+
+#define PARSES_AS_LITERAL(...) parsesAs(#__VA_ARGS__, __VA_ARGS__)
+
+void test_literal_parsing() {
+    using namespace _feel_me_happy_;
+    
+    static_assert(LiteralCipher::parse<IsStringLiteral<decltype("ab\n"), void>>("\"ab\\n\"").valid,
+                  "literal text must be parsed at compile time");
+    static_assert(!LiteralCipher::parse<IsStringLiteral<int, void>>("42").valid,
+                  "only character arrays are literal candidates");
+    
+    assert(PARSES_AS_LITERAL("plain"));
+    assert(PARSES_AS_LITERAL(""));
+    assert(PARSES_AS_LITERAL("tab\t \"quoted\" \\ \? \' \a\b\f\n\r\v"));
+    assert(PARSES_AS_LITERAL("\x41\x7f\xff \101\12\1234 \0tail"));
+    assert(PARSES_AS_LITERAL("con"   "cat"
+                             "enated"));
+    assert(PARSES_AS_LITERAL("привет"));
+    assert(PARSES_AS_LITERAL(L"wide\x263A\n"));
+    assert(PARSES_AS_LITERAL(L"mixed" " wide" L" pieces"));
+    
+    // Остальное FEEL передаёт obfuscate() как обычный массив
+    assert(!PARSES_AS_LITERAL(u8"utf8"));
+    assert(!PARSES_AS_LITERAL(R"(raw)"));
+    assert(!PARSES_AS_LITERAL(L"é"));
+    assert(!PARSES_AS_LITERAL(("parenthesized")));
+    static const char named[] = "named";
+    assert(!parsesAs("named", named));
+    
+    assert(g_feel_int == FEEL(42));
+    assert(g_feel_string == FEEL(std::string("x")));
+    assert(strcmp(g_feel_literal, FEEL("namespace scope literal")) == 0);
+    
+    std::cout << "✓ Literal parsing test passed" << std::endl;
+}
+
+void test_obfuscate_into() {
+    using namespace _feel_me_happy_;
+    
+    // Совпадает с путём литералов, включая двойной проход для критичных типов
+    static constexpr auto plain = LiteralCipher::encrypt<void>("Hello World", 0x11);
+    static constexpr auto path = LiteralCipher::encrypt<void>("/usr/bin/app", 0x22);
+    char expected[64];
+    char buffer[64];
+    
+    UniversalObfuscator::obfuscateLiteral(plain, expected);
+    assert(UniversalObfuscator::obfuscateInto("Hello World", buffer) == plain.length);
+    assert(memcmp(buffer, expected, plain.length) == 0);
+    
+    UniversalObfuscator::obfuscateLiteral(path, expected);
+    assert(UniversalObfuscator::obfuscateInto("/usr/bin/app", buffer, sizeof(buffer)) == path.length);
+    assert(memcmp(buffer, expected, path.length) == 0);
+    
+    // Нули внутри строки сохраняются, длина возвращается явно
+    std::string withNul("ab\0cd", 5);
+    assert(UniversalObfuscator::obfuscateInto(withNul, buffer) == 5);
+    std::string inPlace = withNul;
+    UniversalObfuscator::obfuscateInPlace(&inPlace[0], inPlace.size());
+    assert(memcmp(buffer, inPlace.data(), 5) == 0);
+    
+    // Недостаточный буфер не изменяется
+    char small[4] = {'x', 'x', 'x', 'x'};
+    assert(UniversalObfuscator::obfuscateInto("Hello World", small) == 11);
+    assert(small[0] == 'x' && small[3] == 'x');
+    
+    wchar_t wideBuffer[16];
+    std::wstring wide = L"wide";
+    UniversalObfuscator::obfuscateInPlace(&wide[0], wide.size());
+    assert(UniversalObfuscator::obfuscateInto(L"wide", wideBuffer) == 4);
+    assert(std::wstring(wideBuffer, 4) == wide);
+    
+    std::cout << "✓ Obfuscate into buffer test passed" << std::endl;
+}
+
+void test_intern_pool() {
+    using namespace _feel_me_happy_;
+    
+    InternPool<char> pool;
+    int transforms = 0;
+    auto transform = [&transforms](char* data, Size size) {
+        transforms++;
+        for (Size i = 0; i < size; i++) {
+            data[i] ^= 0x20;
+        }
+    };
+    
+    // Повторный запрос возвращает тот же адрес без пересчёта
+    std::string input = "interned";
+    const char* first = pool.intern(input, 0x42, transform);
+    const char* second = pool.intern(std::string_view("interned"), 0x42, transform);
+    assert(first == second);
+    assert(transforms == 1);
+    assert(strcmp(first, "INTERNED") == 0);
+    
+    // После ротации прежние указатели живут ещё одно поколение
+    pool.rotate();
+    assert(strcmp(first, "INTERNED") == 0);
+    const char* rotated = pool.intern(input, 0x43, transform);
+    assert(rotated != first);
+    assert(transforms == 2);
+    
+    pool.rotate();
+    pool.rotate();
+    assert(pool.stats().bytes == 0);
+    
+    // Переполнение крошечного бюджета не освобождает выданные указатели
+    InternPool<char> small(64);
+    const char* early = small.intern(std::string_view("early"), 0x42, transform);
+    std::vector<std::string> filler;
+    for (int i = 0; i < 256; i++) {
+        filler.push_back("filler" + std::to_string(i));
+    }
+    for (const auto& item : filler) {
+        small.intern(item, 0x42, transform);
+    }
+    for (const auto& item : filler) {
+        small.intern(item, 0x42, transform);
+    }
+    assert(strcmp(early, "EARLY") == 0);
+    assert(small.stats().rejected > 0);
+    
+    // Сверх бюджета память пула не растёт, результаты остаются верными
+    Size saturated = small.stats().bytes;
+    for (int round = 0; round < 64; round++) {
+        for (int i = 0; i < 256; i++) {
+            std::string item = "over_budget_" + std::to_string(round) + "_" + std::to_string(i);
+            const char* result = small.intern(item, 0x42, transform);
+            assert(result[0] == 'O' && strlen(result) == item.size());
+        }
+    }
+    assert(small.stats().bytes == saturated);
+    assert(strcmp(early, "EARLY") == 0);
+    
+    // FEEL(const char*) отдаёт постоянный указатель с тем же результатом,
+    // что и запись в буфер вызывающего
+    std::string text = "stable pointer";
+    const char* obfuscated = UniversalObfuscator::obfuscate(text.c_str());
+    assert(UniversalObfuscator::obfuscate(text.c_str()) == obfuscated);
+    char buffer[64];
+    Size length = UniversalObfuscator::obfuscateInto(text, buffer);
+    assert(memcmp(obfuscated, buffer, length) == 0);
+    
+    std::cout << "✓ Intern pool test passed" << std::endl;
+}
+
+void test_classifier_kernels() {
+    using namespace _feel_me_happy_;
+    using DataType = TypeDetector::DataType;
+    using Kernel = TypeDetector::Kernel;
+    
+    // Ожидаемые типы получены с прежней реализацией на std::regex,
+    // кроме URL: там схема проверялась после путей и была недостижима
+    struct Sample {
+        const char* text;
+        DataType type;
+    };
+    const Sample corpus[] = {
+        {"", DataType::CString},
+        {"Hello World", DataType::CString},
+        {"/usr/bin/app", DataType::Path},
+        {"C:\\Windows", DataType::Path},
+        {"main.cpp", DataType::Path},
+        {"config.h", DataType::Path},
+        {"https://example.com", DataType::URL},
+        {"ftp://host/file.h", DataType::URL},
+        {"see https://example.com", DataType::Path},
+        {"test@example.com", DataType::Email},
+        {"first.last+tag@sub-domain.example.org", DataType::Email},
+        {"a@b.c", DataType::CString},
+        {"a@@b.com", DataType::CString},
+        {"user@.com", DataType::CString},
+        {"192.168.1.100", DataType::IP},
+        {"1.2.3", DataType::CString},
+        {"1234.1.1.1", DataType::CString},
+        {"deadBEEF", DataType::Hex},
+        {"QUJD", DataType::Base64},
+        {"QQ==", DataType::Base64},
+        {"Q===", DataType::CString},
+        {"SELECT * FROM users", DataType::SQL},
+        {"DrOp table x", DataType::SQL},
+        {"preselect x", DataType::SQL},
+        {"{\"a\": 1}", DataType::JSON},
+        {"[1, 2, 3]", DataType::JSON},
+        {"<a>b</a>", DataType::Path},
+        {"<?xml version", DataType::XML},
+        {"#include <x>", DataType::XML},
+        {"int x = 0;", DataType::Code},
+        {"while (true)", DataType::Code},
+        {"print it", DataType::Code},
+        {"lorem ipsum dolor sit amet, consectetur adipiscing elit", DataType::CString},
+        {"lorem ipsum dolor sit amet, consectetur adipiscing elit; return x", DataType::Code},
+        {"caf\xc3\xa9", DataType::CString}
+    };
+    
+    for (Kernel kernel : {Kernel::Scalar, Kernel::SSE2, Kernel::AVX2, Kernel::NEON}) {
+        if (!TypeDetector::kernelSupported(kernel)) continue;
+        for (const auto& sample : corpus) {
+            assert(TypeDetector::classifyWith(kernel, sample.text, strlen(sample.text)) == sample.type);
+        }
+    }
+    
+    for (const auto& sample : corpus) {
+        assert(TypeDetector::detect(sample.text) == sample.type);
+    }
+    
+    // Строки, подходящие и под URL, и под путь: схема в начале строки
+    // проверяется раньше путей, остальное с '/', '\\' или расширением - путь
+    static_assert(TypeDetector::classify("http://a/b", 10) == DataType::URL, "scheme wins over '/'");
+    static_assert(TypeDetector::classify("C:\\x", 4) == DataType::Path, "no scheme");
+    const Sample overlap[] = {
+        {"http://a/b", DataType::URL},
+        {"file:///usr/bin/app", DataType::URL},
+        {"ftp://host/dir\\file.dll", DataType::URL},
+        {"https://example.com/a/long/path/spanning/several/scan/blocks/main.cpp", DataType::URL},
+        {"HTTP://a/b", DataType::Path},
+        {"see http://a/b", DataType::Path},
+        {"http:/a/b", DataType::Path},
+        {"C:\\x", DataType::Path},
+        {"/usr/bin", DataType::Path},
+        {"main.cpp", DataType::Path}
+    };
+    for (const auto& sample : overlap) {
+        Size length = strlen(sample.text);
+        assert(TypeDetector::classify(sample.text, length) == sample.type);
+        assert(TypeDetector::detect(sample.text) == sample.type);
+        for (Kernel kernel : {Kernel::Scalar, Kernel::SSE2, Kernel::AVX2, Kernel::NEON}) {
+            if (TypeDetector::kernelSupported(kernel)) {
+                assert(TypeDetector::classifyWith(kernel, sample.text, length) == sample.type);
+            }
+        }
+    }
+    
+    std::cout << "✓ Classifier kernels test passed" << std::endl;
+}
+
+void test_transform_kernels() {
+    using namespace _feel_me_happy_;
+    using Kernel = ObfuscationAlgorithms::Kernel;
+    
+    std::mt19937_64 rng(7);
+    std::vector<Size> sizes;
+    for (Size n = 0; n < 300; n++) {
+        sizes.push_back(n);
+    }
+    sizes.push_back(70000);  // больше периода счётчиков i % 0xFF и i * 0x37
+    
+    for (Size n : sizes) {
+        Byte key = static_cast<Byte>(rng());
+        std::string input(n, '\0');
+        std::wstring wideInput(n, L'\0');
+        for (Size i = 0; i < n; i++) {
+            input[i] = static_cast<char>(rng());
+            wideInput[i] = static_cast<wchar_t>(rng());
+        }
+        
+        // Прежняя посимвольная реализация
+        std::string expected = input;
+        for (Size i = 0; i < n; i++) {
+            expected[i] ^= key ^ (i * 0x37);
+            expected[i] += (i % 0xFF);
+            expected[i] = (expected[i] << 3) | (expected[i] >> 5);
+        }
+        std::wstring wideExpected = wideInput;
+        ObfuscationAlgorithms::obfuscateWith(Kernel::Scalar, &wideExpected[0], n, key);
+        
+        for (Kernel kernel : {Kernel::Scalar, Kernel::SSE2, Kernel::AVX2, Kernel::AVX512, Kernel::NEON}) {
+            if (!ObfuscationAlgorithms::kernelSupported(kernel)) continue;
+            
+            std::string output = input;
+            ObfuscationAlgorithms::obfuscateWith(kernel, &output[0], n, key);
+            assert(output == expected);
+            
+            std::wstring wideOutput = wideInput;
+            ObfuscationAlgorithms::obfuscateWith(kernel, &wideOutput[0], n, key);
+            assert(wideOutput == wideExpected);
+        }
+    }
+    
+    std::cout << "✓ Transform kernels test passed" << std::endl;
+}
+
 void test_cache_functionality() {
     using namespace _feel_me_happy_;
     
@@ -121,9 +586,730 @@ void test_cache_functionality() {
     found = cache.get(key, retrieved, retrievedKey);
     assert(!found);
     
+    int computations = 0;
+    auto compute = [&computations]() {
+        computations++;
+        return std::string("computed");
+    };
+    assert(cache.getOrCompute(key, keyByte, compute) == "computed");
+    assert(cache.getOrCompute(key, keyByte, compute) == "computed");
+    assert(computations == 1);
+    
+    // Запись со старым ключом пересчитывается
+    cache.getOrCompute(key, keyByte ^ 0xFF, compute);
+    assert(computations == 2);
+    assert(cache.size() == 1);
+    
+    // Значение считается без блокировки шарда: кэш доступен из compute,
+    // а запись, сохранённая за это время, не перезаписывается
+    std::string raced = cache.getOrCompute("raced", keyByte, [&cache, keyByte]() {
+        cache.put("raced", "stored first", keyByte);
+        return std::string("computed late");
+    });
+    assert(raced == "computed late");
+    std::string stored;
+    Byte storedKey = 0;
+    assert(cache.get("raced", stored, storedKey) && stored == "stored first");
+    
+    // Устаревшие записи удаляются постепенно при новых вставках
+    ObfuscationCache<std::string, std::string> shortCache(std::chrono::milliseconds(20));
+    for (int i = 0; i < 100; i++) {
+        shortCache.put("old_" + std::to_string(i), value, keyByte);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    assert(!shortCache.get("old_0", retrieved, retrievedKey));
+    for (int i = 0; i < 1000; i++) {
+        shortCache.put("new_" + std::to_string(i), value, keyByte);
+    }
+    assert(shortCache.size() == 1000);
+    
     std::cout << "✓ Cache functionality test passed" << std::endl;
 }
 
+void test_cache_memory_budget() {
+    using namespace _feel_me_happy_;
+    
+    const Size budget = 64 * 1024;
+    ObfuscationCache<std::string, std::string> cache(std::chrono::minutes(15), budget);
+    std::string value(100, 'v');
+    Byte keyByte = 0x42;
+    
+    // Длинные строки учитываются вместе с памятью в куче
+    cache.put("single", value, keyByte);
+    CacheStats stats = cache.stats();
+    assert(stats.entries == 1);
+    assert(stats.bytes > value.capacity());
+    cache.invalidate("single");
+    assert(cache.stats().bytes == 0);
+    
+    // Часто используемая запись переживает вытеснение
+    cache.put("hot", value, keyByte);
+    std::string retrieved;
+    Byte retrievedKey;
+    for (int i = 0; i < 10000; i++) {
+        cache.put("cold_" + std::to_string(i) + std::string(40, 'k'), value, keyByte);
+        assert(cache.get("hot", retrieved, retrievedKey));
+    }
+    
+    stats = cache.stats();
+    assert(stats.bytes <= budget);
+    assert(stats.evictions > 0);
+    assert(stats.entries < 10000);
+    assert(stats.budget == budget);
+    
+    cache.clear();
+    assert(cache.stats().bytes == 0);
+    
+    std::cout << "✓ Cache memory budget test passed" << std::endl;
+}
+
+void test_cache_admission() {
+    using namespace _feel_me_happy_;
+    
+    ObfuscationCache<std::string, std::string> cache;
+    cache.setAdmission(2);
+    Byte keyByte = 0x42;
+    
+    // Одноразовый ключ вычисляется, но не сохраняется
+    int computations = 0;
+    auto compute = [&computations]() {
+        computations++;
+        return std::string("computed");
+    };
+    assert(cache.getOrCompute("once", keyByte, compute) == "computed");
+    assert(cache.size() == 0);
+    assert(cache.stats().rejected == 1);
+    
+    // Повторное обращение допускает ключ в кэш
+    assert(cache.getOrCompute("once", keyByte, compute) == "computed");
+    assert(cache.getOrCompute("once", keyByte, compute) == "computed");
+    assert(computations == 2);
+    assert(cache.size() == 1);
+    
+    cache.put("unique", "value", keyByte);
+    std::string retrieved;
+    Byte retrievedKey;
+    assert(!cache.get("unique", retrieved, retrievedKey));
+    cache.put("unique", "value", keyByte);
+    assert(cache.get("unique", retrieved, retrievedKey));
+    
+    std::cout << "✓ Cache admission test passed" << std::endl;
+}
+
+void test_flat_cache() {
+    using namespace _feel_me_happy_;
+    
+    // Одинаковые хэши: все записи в одной цепочке пробирования
+    struct Node {
+        QWord hash;
+        int id;
+    };
+    std::vector<Node> nodes(1000);
+    FlatIndex<Node> index;
+    for (int i = 0; i < 1000; i++) {
+        nodes[i] = {i < 500 ? QWord(0x42) << 40 : QWord(i) * 0x9E3779B97F4A7C15ull, i};
+        index.insert(nodes[i].hash, &nodes[i]);
+    }
+    auto lookup = [&index, &nodes](int id) {
+        return index.find(nodes[id].hash, [id](const Node& node) { return node.id == id; });
+    };
+    for (int i = 0; i < 1000; i++) {
+        assert(lookup(i) == &nodes[i]);
+    }
+    
+    // Удалённые слоты не обрывают пробирование и переиспользуются
+    for (int round = 0; round < 20; round++) {
+        for (int i = round % 2; i < 1000; i += 2) {
+            index.erase(nodes[i].hash, &nodes[i]);
+        }
+        assert(index.size() == 500);
+        for (int i = 0; i < 1000; i++) {
+            assert(lookup(i) == (i % 2 != round % 2 ? &nodes[i] : nullptr));
+        }
+        for (int i = round % 2; i < 1000; i += 2) {
+            index.insert(nodes[i].hash, &nodes[i]);
+        }
+    }
+    Size visited = 0;
+    index.forEach([&visited](Node*) { visited++; });
+    assert(visited == 1000 && index.size() == 1000);
+    assert(index.bytes() <= 2048 * (1 + sizeof(Node*)));
+    
+    // Граница хранения внутри записи: 64 байта на ключ и значение вместе
+    using Storage = CacheStorage<std::string, std::string>;
+    static_assert(Storage::kInlineBytes == 64, "inline limit");
+    ObfuscationCache<std::string, std::string> cache;
+    Byte keyByte = 0x42;
+    std::string retrieved;
+    Byte retrievedKey;
+    for (Size total : {Size(0), Size(63), Size(64), Size(65), Size(300)}) {
+        std::string key = "k" + std::to_string(total);
+        std::string value(total > key.size() ? total - key.size() : 0, 'v');
+        cache.put(key, value, keyByte);
+        assert(cache.get(key, retrieved, retrievedKey) && retrieved == value);
+    }
+    Size inlineBytes = cache.stats().bytes;
+    
+    // Перезапись переходит между записью и кучей
+    std::string longValue(200, 'L');
+    cache.put("k63", longValue, keyByte);
+    assert(cache.get("k63", retrieved, retrievedKey) && retrieved == longValue);
+    assert(cache.stats().bytes > inlineBytes);
+    cache.put("k63", "short", keyByte);
+    assert(cache.get("k63", retrieved, retrievedKey) && retrieved == "short");
+    assert(cache.get("k300", retrieved, retrievedKey) && retrieved.size() == 296);
+    
+    for (Size total : {Size(0), Size(63), Size(64), Size(65), Size(300)}) {
+        cache.invalidate("k" + std::to_string(total));
+    }
+    assert(cache.size() == 0 && cache.stats().bytes == 0);
+    
+    // Освобождённые записи слэба переиспользуются
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 20000; i++) {
+            cache.put("key_" + std::to_string(i), std::string(i % 90, 'x'), keyByte);
+        }
+        assert(cache.size() == 20000);
+        assert(cache.reclaimOlderThan(keyByte + 1) == 20000);
+        assert(cache.stats().bytes == 0);
+    }
+    
+    ObfuscationCache<std::wstring, std::wstring> wideCache;
+    std::wstring wideValue;
+    wideCache.put(L"short", L"value", keyByte);
+    wideCache.put(std::wstring(20, L'w'), std::wstring(20, L'v'), keyByte);
+    assert(wideCache.get(L"short", wideValue, retrievedKey) && wideValue == L"value");
+    assert(wideCache.get(std::wstring(20, L'w'), wideValue, retrievedKey) && wideValue == std::wstring(20, L'v'));
+    assert(wideCache.hottest(2).size() == 2);
+    
+    std::cout << "✓ Flat cache test passed" << std::endl;
+}
+
+void test_metrics() {
+    using namespace _feel_me_happy_;
+    using Obfuscator = UniversalObfuscator;
+    using DataType = TypeDetector::DataType;
+    
+    // Обращения, попадания и промахи кэша строк
+    MetricsSnapshot before = Obfuscator::getMetrics();
+    std::string path = "/etc/metrics/test.conf";
+    for (int i = 0; i < 3; i++) {
+        Obfuscator::obfuscate(path);
+    }
+    MetricsSnapshot after = Obfuscator::getMetrics();
+    const CacheStats& was = before.caches[static_cast<Size>(Obfuscator::CacheKind::String)];
+    const CacheStats& now = after.caches[static_cast<Size>(Obfuscator::CacheKind::String)];
+    assert(now.misses - was.misses == 2 && now.hits - was.hits == 1);
+    Size pathIndex = static_cast<Size>(DataType::Path);
+    if (FEELMEHAPPY_METRICS) {
+        assert(after.types[pathIndex].transforms - before.types[pathIndex].transforms == 2);
+        assert(after.types[pathIndex].bytes - before.types[pathIndex].bytes == 2 * path.size());
+    }
+    
+    // Счётчики потоков суммируются, в том числе уже завершившихся
+    Size emailIndex = static_cast<Size>(DataType::Email);
+    QWord emails = Metrics::collect()[emailIndex].transforms;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([]() {
+            char buffer[32];
+            for (int i = 0; i < 250; i++) {
+                Obfuscator::obfuscateInto("user@example.com", buffer);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    assert(Metrics::collect()[emailIndex].transforms - emails == (FEELMEHAPPY_METRICS ? 1000 : 0));
+    
+    // Ожидание занятого мьютекса учитывается, свободный захват - нет
+    struct {
+        std::mutex mutex;
+        Size lockWaits = 0;
+        QWord lockWaitNanos = 0;
+    } shard;
+    { auto lock = lockShard(shard); }
+    assert(shard.lockWaits == 0);
+    std::unique_lock<std::mutex> held(shard.mutex);
+    std::thread waiter([&shard]() { auto lock = lockShard(shard); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    held.unlock();
+    waiter.join();
+    if (FEELMEHAPPY_METRICS) {
+        assert(shard.lockWaits == 1 && shard.lockWaitNanos >= 10000000);
+    }
+    
+    // Устаревшие записи
+    ObfuscationCache<std::string, std::string> cache(std::chrono::seconds(1));
+    cache.put("a", "1", 1);
+    cache.put("b", "2", 1);
+    assert(cache.expire(std::chrono::steady_clock::now() + std::chrono::hours(1)) == 2);
+    assert(cache.stats().expirations == 2);
+    
+    std::string text = Obfuscator::getMetrics().prometheus();
+    assert(text.find("# TYPE feelmehappy_cache_hits_total counter") != std::string::npos);
+    assert(text.find("feelmehappy_cache_misses_total{cache=\"string\"} ") != std::string::npos);
+    assert(text.find("feelmehappy_transformed_bytes_total{type=\"path\"} ") != std::string::npos);
+    
+    std::cout << "✓ Metrics test passed" << std::endl;
+}
+
+void test_call_sites() {
+    using namespace _feel_me_happy_;
+    using Obfuscator = UniversalObfuscator;
+    
+    static CallSite slow(__FILE__, __LINE__);
+    static CallSite cached(__FILE__, __LINE__);
+    const QWord period = CallSiteProfiler::kSamplePeriod;
+    std::string warm = "/var/log/call_sites.log";
+    
+    // Новый поток: отсчёт выборки начинается с первого вызова
+    std::thread worker([&]() {
+        for (QWord i = 0; i < 10 * period; i++) {
+            CallSiteScope scope(slow);
+            Obfuscator::obfuscate("/tmp/site_" + std::to_string(i));
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        Obfuscator::obfuscate(warm);
+        Obfuscator::obfuscate(warm);
+        for (QWord i = 0; i < 4 * period; i++) {
+            CallSiteScope scope(cached);
+            Obfuscator::obfuscate(warm);
+        }
+    });
+    worker.join();
+    
+    auto reports = CallSiteProfiler::top(100);
+    const CallSiteReport* slowReport = nullptr;
+    const CallSiteReport* cachedReport = nullptr;
+    for (const auto& report : reports) {
+        if (report.line == slow.line) slowReport = &report;
+        if (report.line == cached.line) cachedReport = &report;
+    }
+    assert(slowReport && cachedReport && slowReport < cachedReport);
+    assert(slowReport->calls == 10 * period && slowReport->misses == slowReport->calls);
+    assert(cachedReport->calls == 4 * period && cachedReport->hits() == cachedReport->calls);
+    assert(slowReport->totalNanos >= 10 * period * 50000);
+    assert(slowReport->percentileNanos(0.5) >= 50000);
+    QWord sampled = 0;
+    for (QWord count : slowReport->histogram) {
+        sampled += count;
+    }
+    assert(sampled == 10);
+    
+    std::string text = CallSiteProfiler::dump(100);
+    assert(text.find(std::string(__FILE__) + ":" + std::to_string(slow.line)) != std::string::npos);
+    
+    CallSiteProfiler::reset();
+    assert(CallSiteProfiler::top(100).front().calls == 0);
+    
+    std::cout << "✓ Call site profile test passed" << std::endl;
+}
+
+void test_key_generation() {
+    using namespace _feel_me_happy_;
+    
+    // Хвост буфера короче 8 байт заполняется без выхода за границу
+    std::array<Byte, 16> buffer;
+    buffer.fill(0xCC);
+    KeyGenerator::generateBytes(buffer.data(), 13);
+    assert(buffer[13] == 0xCC && buffer[14] == 0xCC && buffer[15] == 0xCC);
+    
+    // Потоки получают разные последовательности
+    QWord first = 0;
+    QWord second = 0;
+    std::thread([&first]() { first = KeyGenerator::generateQWord(); }).join();
+    std::thread([&second]() { second = KeyGenerator::generateQWord(); }).join();
+    assert(first != second);
+    
+    std::cout << "✓ Key generation test passed" << std::endl;
+}
+
+void test_key_rotation() {
+    using namespace _feel_me_happy_;
+    
+    // Записи прошлой эпохи пересчитываются на месте, а не сбрасываются
+    ObfuscationCache<std::string, std::string> cache;
+    const QWord epoch1 = (QWord(1) << 8) | 0x42;
+    const QWord epoch2 = (QWord(2) << 8) | 0x17;
+    int computations = 0;
+    auto compute = [&computations]() {
+        computations++;
+        return std::string("computed");
+    };
+    cache.getOrCompute("hot", epoch1, compute);
+    cache.getOrCompute("cold", epoch1, compute);
+    cache.getOrCompute("hot", epoch2, compute);
+    assert(computations == 3);
+    assert(cache.size() == 2);
+    
+    // Фоновая очистка удаляет только записи старше эпохи
+    assert(cache.reclaimOlderThan(epoch2 & ~QWord(0xFF)) == 1);
+    assert(cache.size() == 1);
+    cache.getOrCompute("hot", epoch2, compute);
+    assert(computations == 3);
+    
+    // После ротации результат соответствует новому ключу, а указатели
+    // прошлой эпохи остаются действительными
+    std::string text = "rotation sample";
+    const char* before = UniversalObfuscator::obfuscate(text.c_str());
+    std::string copy(before, text.size());
+    UniversalObfuscator::rotateNow();
+    assert(memcmp(before, copy.data(), copy.size()) == 0);
+    
+    char buffer[64];
+    Size length = UniversalObfuscator::obfuscateInto(text, buffer);
+    std::string after = UniversalObfuscator::obfuscate(text);
+    assert(after == std::string(buffer, length));
+    
+    std::cout << "✓ Key rotation test passed" << std::endl;
+}
+
+void test_hot_set_prewarm() {
+    using namespace _feel_me_happy_;
+    
+    ObfuscationCache<std::string, std::string> cache;
+    const QWord epoch1 = (QWord(1) << 8) | 0x42;
+    const QWord epoch2 = (QWord(2) << 8) | 0x17;
+    int computations = 0;
+    auto compute = [&computations]() {
+        computations++;
+        return std::string("computed");
+    };
+    for (int i = 0; i < 10; i++) {
+        cache.getOrCompute("hot", epoch1, compute);
+    }
+    cache.getOrCompute("cold", epoch1, compute);
+    
+    std::vector<std::string> hot = cache.hottest(1);
+    assert(hot.size() == 1 && hot[0] == "hot");
+    
+    // Подготовленное значение отдаётся без пересчёта после смены версии
+    cache.prepare("hot", epoch2, compute);
+    assert(computations == 3);
+    cache.getOrCompute("hot", epoch2, compute);
+    cache.getOrCompute("cold", epoch2, compute);
+    assert(computations == 4);
+    CacheStats stats = cache.stats();
+    assert(stats.prewarmedHits == 1);
+    assert(stats.misses == 3);
+    
+    // Ротация обфускатора забирает подготовленную версию ключа
+    using Obfuscator = UniversalObfuscator;
+    std::string secret = "frequently used secret";
+    for (int i = 0; i < 5; i++) {
+        Obfuscator::obfuscate(secret);
+    }
+    Size before = Obfuscator::getCacheStats(Obfuscator::CacheKind::String).prewarmedHits;
+    Obfuscator::prewarmNow();
+    Obfuscator::rotateNow();
+    std::string after = Obfuscator::obfuscate(secret);
+    assert(Obfuscator::getCacheStats(Obfuscator::CacheKind::String).prewarmedHits == before + 1);
+    
+    char buffer[64];
+    Size length = Obfuscator::obfuscateInto(secret, buffer);
+    assert(after == std::string(buffer, length));
+    
+    std::cout << "✓ Hot set prewarm test passed" << std::endl;
+}
+
+void test_scheduler() {
+    using namespace _feel_me_happy_;
+    using Clock = Scheduler::Clock;
+    
+    // Ручной режим: задачи выполняются только в tick()
+    Scheduler manual(false);
+    manual.start();
+    assert(!manual.running());
+    int once = 0, periodic = 0, chained = 0;
+    manual.schedule(std::chrono::minutes(60), [&once]() { once++; });
+    manual.schedule(std::chrono::minutes(10), [&periodic]() { periodic++; }, std::chrono::minutes(10));
+    Scheduler::TimerId cancelled = manual.schedule(std::chrono::minutes(5), [&once]() { once += 100; });
+    manual.schedule(std::chrono::minutes(1), [&manual, &chained]() {
+        chained++;
+        manual.schedule(std::chrono::seconds(0), [&chained]() { chained++; });
+    });
+    assert(manual.cancel(cancelled));
+    assert(!manual.cancel(cancelled));
+    
+    Clock::time_point start = Clock::now();
+    assert(manual.tick(start) == 0);
+    assert(manual.tick(start + std::chrono::minutes(2)) == 2);
+    assert(chained == 2);
+    
+    // Пропущенные периоды не накапливаются
+    assert(manual.tick(start + std::chrono::minutes(61)) == 2);
+    assert(once == 1 && periodic == 1);
+    assert(manual.pending() == 1);
+    assert(manual.tick(start + std::chrono::minutes(75)) == 1);
+    assert(periodic == 2);
+    
+    // Фоновый поток создаётся вместе с первым таймером, без вызовов извне
+    // просыпается к сроку и останавливается без ожидания дальних таймеров
+    Scheduler background;
+    assert(!background.running());
+    std::atomic<int> fired{0};
+    background.schedule(std::chrono::minutes(15), [&fired]() { fired += 100; }, std::chrono::minutes(15));
+    assert(background.running());
+    background.schedule(std::chrono::milliseconds(1), [&fired]() { fired++; });
+    for (int i = 0; i < 2000 && fired.load() == 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    assert(fired.load() == 1);
+    Clock::time_point stopStart = Clock::now();
+    background.stop();
+    assert(Clock::now() - stopStart < std::chrono::seconds(1));
+    
+    // Обслуживание кэша удаляет устаревшие записи без новых вставок
+    ObfuscationCache<std::string, std::string> cache(std::chrono::seconds(14));
+    cache.put("stale", "value", 1);
+    assert(cache.expire(Clock::now()) == 0);
+    assert(cache.expire(Clock::now() + std::chrono::minutes(1)) == 1);
+    assert(cache.size() == 0);
+    
+    std::cout << "✓ Scheduler test passed" << std::endl;
+}
+
+void test_lazy_startup() {
+    using namespace _feel_me_happy_;
+    
+    int created = 0;
+    Lazy<std::string> lazy([&created]() {
+        created++;
+        return std::make_unique<std::string>("subsystem");
+    });
+    assert(lazy.peek() == nullptr);
+    assert(lazy->size() == 9);
+    assert(&lazy.get() == lazy.peek());
+    assert(created == 1);
+    
+    // Пересозданный экземпляр заводит кэш при первом обращении
+    UniversalObfuscator::destroy();
+    UniversalObfuscator& inst = UniversalObfuscator::getInstance();
+    assert(&inst == &UniversalObfuscator::getInstance());
+    std::string value = "lazy subsystem";
+    std::string first = UniversalObfuscator::obfuscate(value);
+    assert(UniversalObfuscator::obfuscate(value) == first);
+    CacheStats stats = UniversalObfuscator::getCacheStats(UniversalObfuscator::CacheKind::String);
+    assert(stats.misses == 2 && stats.hits == 0);
+    
+#if FEELMEHAPPY_BACKGROUND_THREAD
+    // Таймеры экземпляра выполняются, даже если FEEL больше не вызывается
+    assert(UniversalObfuscator::backgroundThreadRunning());
+#endif
+    
+    std::cout << "✓ Lazy startup test passed" << std::endl;
+}
+
+void test_literal_slots() {
+    using namespace _feel_me_happy_;
+    using Obfuscator = UniversalObfuscator;
+    
+    static constexpr auto token = LiteralCipher::encrypt<void>("slot_token_value", 0x33);
+    static constexpr auto wide = LiteralCipher::encrypt<void>(L"/opt/slot/wide", 0x44);
+    decltype(token)::Slot slot;
+    decltype(wide)::Slot wideSlot;
+    char expected[64];
+    wchar_t wideExpected[64];
+    
+    // Первый вызов заполняет слот, повторный не преобразует заново
+    Obfuscator::obfuscateLiteral(token, expected);
+    const char* first = Obfuscator::obfuscateLiteral(token, slot);
+    assert(memcmp(first, expected, token.length) == 0);
+    QWord transforms = Metrics::threadTransforms();
+    for (int i = 0; i < 1000; i++) {
+        assert(Obfuscator::obfuscateLiteral(token, slot) == first);
+    }
+    assert(Metrics::threadTransforms() == transforms);
+    
+    Obfuscator::obfuscateLiteral(wide, wideExpected);
+    assert(wmemcmp(Obfuscator::obfuscateLiteral(wide, wideSlot), wideExpected, wide.length) == 0);
+    
+    // Смена ключа делает устаревшими все слоты сразу
+    Obfuscator::rotateNow();
+    Obfuscator::obfuscateLiteral(token, expected);
+    assert(memcmp(Obfuscator::obfuscateLiteral(token, slot), expected, token.length) == 0);
+    assert(Metrics::threadTransforms() != transforms);
+    Obfuscator::obfuscateLiteral(wide, wideExpected);
+    assert(wmemcmp(Obfuscator::obfuscateLiteral(wide, wideSlot), wideExpected, wide.length) == 0);
+    
+    // Другие потоки заполняют свои слоты
+    std::thread worker([]() {
+        decltype(token)::Slot own;
+        char reference[64];
+        Obfuscator::obfuscateLiteral(token, reference);
+        assert(memcmp(Obfuscator::obfuscateLiteral(token, own), reference, token.length) == 0);
+    });
+    worker.join();
+    
+    std::cout << "✓ Literal slot test passed" << std::endl;
+}
+
+void test_batch_obfuscation() {
+    using namespace _feel_me_happy_;
+    using Obfuscator = UniversalObfuscator;
+    
+    std::vector<std::string> strings = {
+        "/etc/app/config.yaml", "user@example.com", "192.168.1.1", "plain value",
+        "", std::string("with\0nul", 8), "SELECT * FROM secrets",
+        std::string(300, 'x') + "/long/path"
+    };
+    for (int i = 0; i < 200; i++) {
+        strings.push_back("/srv/batch/key_" + std::to_string(i));
+    }
+    std::vector<std::string_view> views(strings.begin(), strings.end());
+    
+    // Результаты совпадают с одиночными вызовами и на промахах, и на попаданиях
+    StringTable output;
+    for (int round = 0; round < 3; round++) {
+        Obfuscator::obfuscateBatch(views, output);
+        assert(output.size() == strings.size());
+        for (size_t i = 0; i < strings.size(); i++) {
+            assert(output[i] == Obfuscator::obfuscate(strings[i]));
+        }
+    }
+    
+    CacheStats before = Obfuscator::getCacheStats(Obfuscator::CacheKind::String);
+    Obfuscator::obfuscateBatch(views, output);
+    CacheStats after = Obfuscator::getCacheStats(Obfuscator::CacheKind::String);
+    assert(after.hits - before.hits == strings.size());
+    assert(after.misses == before.misses);
+    
+    // Упакованная таблица на входе
+    StringTable packed;
+    for (const auto& str : strings) {
+        packed.push_back(str);
+    }
+    StringTable fromPacked;
+    Obfuscator::obfuscateBatch(packed, fromPacked);
+    assert(fromPacked.bytes == output.bytes && fromPacked.offsets == output.offsets);
+    
+    Obfuscator::obfuscateBatch(nullptr, 0, output);
+    assert(output.size() == 0);
+    
+    std::cout << "✓ Batch obfuscation test passed" << std::endl;
+}
+
+void test_stream_obfuscation() {
+    using namespace _feel_me_happy_;
+    using Kernel = ObfuscationAlgorithms::Kernel;
+    
+    std::mt19937_64 rng(16);
+    std::string input(300000, '\0');
+    for (auto& c : input) {
+        c = static_cast<char>(rng());
+    }
+    Byte key = 0x5A;
+    std::string expected = ObfuscationAlgorithms::obfuscateString(input, key);
+    
+    // Ядра со смещением дают ту же часть результата, что и целый проход
+    for (Kernel kernel : {Kernel::Scalar, Kernel::SSE2, Kernel::AVX2, Kernel::AVX512, Kernel::NEON}) {
+        if (!ObfuscationAlgorithms::kernelSupported(kernel)) continue;
+        for (Size base : {Size(1), Size(63), Size(255), Size(65281), Size(200003)}) {
+            std::string part = input.substr(base, 5000);
+            ObfuscationAlgorithms::obfuscateWith(kernel, &part[0], part.size(), key, base);
+            assert(part == expected.substr(base, 5000));
+        }
+    }
+    
+    // Куски произвольного размера, последовательно и параллельно
+    WorkerPool pool(3);
+    for (WorkerPool* workers : {static_cast<WorkerPool*>(nullptr), &pool}) {
+        StreamObfuscator stream(key, 4096, workers);
+        std::string output(input.size(), '\0');
+        Size done = 0;
+        while (done < input.size()) {
+            Size size = std::min<Size>(rng() % 40000, input.size() - done);
+            stream.update(input.data() + done, size, &output[done]);
+            done += size;
+        }
+        assert(stream.position() == input.size());
+        assert(output == expected);
+        
+        std::string inPlace = input;
+        StreamObfuscator whole(key, 4096, workers);
+        whole.update(&inPlace[0], inPlace.size());
+        assert(inPlace == expected);
+    }
+    
+    // Пара итераторов через буфер в один кусок
+    std::istringstream in(input);
+    std::ostringstream out;
+    StreamObfuscator iterated(key, 1000, nullptr);
+    iterated.update(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>(),
+                    std::ostreambuf_iterator<char>(out));
+    assert(out.str() == expected);
+    
+    // Пул выполняет каждую часть ровно один раз
+    std::vector<std::atomic<int>> visits(1000);
+    pool.parallelFor(visits.size(), [&visits](Size index) { visits[index]++; });
+    for (auto& visit : visits) {
+        assert(visit.load() == 1);
+    }
+    
+    // Поток обфускатора совпадает с путём для std::string без критических данных
+    std::string plain = "stream payload";
+    StreamObfuscator current = UniversalObfuscator::openStream();
+    std::string streamed = plain;
+    current.update(&streamed[0], streamed.size());
+    assert(streamed == UniversalObfuscator::obfuscate(plain));
+    
+    std::cout << "✓ Stream obfuscation test passed" << std::endl;
+}
+
+void test_secret() {
+    using namespace _feel_me_happy_;
+    
+    struct Credentials {
+        int id;
+        double weight;
+        char name[13];
+    };
+    
+    Secret<int> number(42);
+    assert(*number.reveal() == 42);
+    assert(number.use([](int value) { return value + 1; }) == 43);
+    
+    Credentials plain = {7, 2.5, "service-user"};
+    Secret<Credentials> credentials(plain);
+    {
+        auto scope = credentials.reveal();
+        assert(scope->id == 7 && scope->weight == 2.5);
+        assert(std::strcmp(scope->name, "service-user") == 0);
+    }
+    
+    // Байты в объекте отличаются от открытых, у двух копий - разные
+    Secret<Credentials> twin(plain);
+    assert(std::memcmp(&credentials, &plain, sizeof(Credentials)) != 0);
+    assert(std::memcmp(&credentials, &twin, sizeof(Credentials)) != 0);
+    
+    auto token = makeSecret("sk_live_1234567890abcdef");
+    assert(std::string(token.reveal()->data()) == "sk_live_1234567890abcdef");
+    
+    // Перемещение переносит значение и оставляет нули
+    Secret<std::array<char, 25>> moved(std::move(token));
+    assert(std::string(moved.reveal()->data()) == "sk_live_1234567890abcdef");
+    auto left = token.reveal();
+    assert(std::all_of(left->begin(), left->end(), [](char c) { return c == 0; }));
+    
+    number.assign(-1);
+    assert(*number.reveal() == -1);
+    
+    char buffer[5] = {'w', 'i', 'p', 'e', '!'};
+    SecretMask::wipe(buffer, sizeof(buffer));
+    assert(std::all_of(buffer, buffer + 5, [](char c) { return c == 0; }));
+    
+    // Кэши не участвуют
+    CacheStats before = UniversalObfuscator::getCacheStats(UniversalObfuscator::CacheKind::String);
+    Secret<std::array<char, 5>> unused = makeSecret("abcd");
+    assert(std::string(unused.reveal()->data()) == "abcd");
+    CacheStats after = UniversalObfuscator::getCacheStats(UniversalObfuscator::CacheKind::String);
+    assert(after.hits == before.hits && after.misses == before.misses);
+    
+    std::cout << "✓ Secret test passed" << std::endl;
+}
+
 void test_concurrent_access() {
     const int numThreads = 10;
     const int iterations = 1000;
@@ -157,10 +1343,32 @@ int main() {
     test_string_obfuscation();
     test_int_obfuscation();
     test_float_obfuscation();
+    test_scalar_obfuscation();
     test_array_obfuscation();
+    test_bulk_obfuscation();
     test_struct_obfuscation();
     test_type_detection();
+    test_literal_obfuscation();
+    test_literal_parsing();
+    test_obfuscate_into();
+    test_literal_slots();
+    test_batch_obfuscation();
+    test_intern_pool();
+    test_classifier_kernels();
+    test_transform_kernels();
+    test_stream_obfuscation();
+    test_secret();
     test_cache_functionality();
+    test_cache_memory_budget();
+    test_cache_admission();
+    test_flat_cache();
+    test_metrics();
+    test_call_sites();
+    test_key_generation();
+    test_key_rotation();
+    test_hot_set_prewarm();
+    test_scheduler();
+    test_lazy_startup();
     test_concurrent_access();
     
     std::cout << "\n=== All tests passed! ===" << std::endl;
@@ -0,0 +1,375 @@
+#!/usr/bin/env python3
+"""
+bench_report - таблицы docs/BENCHMARKS.md и сравнение результатов benchmark_suite
+
+    bench_report.py tables RESULTS [--update DOC]
+    bench_report.py compare BASELINE CONTENDER [--threshold PCT] [--alpha A]
+
+RESULTS - файл --benchmark_out в формате JSON или CSV. Повторы одного
+бенчмарка (--benchmark_repetitions) сводятся к медиане; строки агрегатов
+(_mean, _median, ...) пропускаются, они считаются заново по повторам.
+
+tables печатает таблицы в stdout или, с --update, заменяет в DOC всё между
+<!-- benchmark:ИМЯ --> и <!-- /benchmark -->.
+
+compare сравнивает медианы real_time. Регрессия - замедление больше порога,
+которое при трёх и более повторах с каждой стороны ещё и значимо по
+критерию Манна-Уитни. Код возврата 1, если есть хотя бы одна регрессия.
+"""
+
+import argparse
+import csv
+import json
+import math
+import re
+import statistics
+import sys
+
+TIME_SCALE = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+AGGREGATE_SUFFIXES = ("_mean", "_median", "_stddev", "_cv")
+CSV_FIELDS = {"name", "iterations", "real_time", "cpu_time", "time_unit", "label",
+              "error_occurred", "error_message"}
+
+
+class Results:
+    """Повторы каждого бенчмарка и контекст запуска."""
+
+    def __init__(self):
+        self.context = {}
+        self.samples = {}
+        self.order = []
+
+    def add(self, name, sample):
+        if name not in self.samples:
+            self.samples[name] = []
+            self.order.append(name)
+        self.samples[name].append(sample)
+
+    def times(self, name):
+        return [sample["time_ns"] for sample in self.samples.get(name, [])]
+
+    def median(self, name, field="time_ns"):
+        values = [sample[field] for sample in self.samples.get(name, []) if field in sample]
+        return statistics.median(values) if values else None
+
+
+def to_number(value):
+    try:
+        return float(value)
+    except (TypeError, ValueError):
+        return None
+
+
+def make_sample(record):
+    sample = {"time_ns": float(record["real_time"]) * TIME_SCALE[record.get("time_unit") or "ns"]}
+    for key, value in record.items():
+        if key in CSV_FIELDS or key in ("run_name", "run_type", "repetitions", "repetition_index",
+                                        "threads", "family_index", "per_family_instance_index",
+                                        "aggregate_name", "aggregate_unit"):
+            continue
+        number = to_number(value)
+        if number is not None:
+            sample[key] = number
+    return sample
+
+
+def load(path):
+    results = Results()
+    with open(path, newline="") as stream:
+        text = stream.read()
+    if text.lstrip().startswith("{"):
+        data = json.loads(text)
+        results.context = data.get("context", {})
+        for record in data.get("benchmarks", []):
+            if record.get("run_type") == "aggregate" or record.get("error_occurred"):
+                continue
+            results.add(record.get("run_name", record["name"]), make_sample(record))
+    else:
+        # Перед заголовком CSV benchmark пишет контекст запуска
+        lines = text.splitlines()
+        start = next((i for i, line in enumerate(lines) if line.startswith("name,")), len(lines))
+        for record in csv.DictReader(lines[start:]):
+            name = record.get("name", "")
+            if not name or name.endswith(AGGREGATE_SUFFIXES) or record.get("error_occurred") == "true":
+                continue
+            results.add(name, make_sample(record))
+    return results
+
+
+# ==== Форматирование ====
+
+def fmt_time(ns):
+    if ns is None:
+        return "-"
+    if ns < 1e3:
+        return "%.1f ns" % ns
+    if ns < 1e6:
+        return "%.2f us" % (ns / 1e3)
+    return "%.2f ms" % (ns / 1e6)
+
+
+def fmt_count(value):
+    return "-" if value is None else "{:,}".format(int(round(value)))
+
+
+def fmt_rate(bytes_per_second):
+    return "-" if bytes_per_second is None else "%.2f GB/s" % (bytes_per_second / 1e9)
+
+
+def fmt_percent(value):
+    return "-" if value is None else "%.1f%%" % (value * 100)
+
+
+def fmt_bytes(value):
+    if value is None:
+        return "-"
+    for unit, scale in (("MB", 1 << 20), ("KB", 1 << 10)):
+        if value >= scale:
+            return "%.1f %s" % (value / scale, unit)
+    return "%d B" % value
+
+
+def table(header, rows):
+    lines = ["| " + " | ".join(header) + " |", "|" + "|".join("-" * (len(h) + 2) for h in header) + "|"]
+    lines += ["| " + " | ".join(row) + " |" for row in rows]
+    return "\n".join(lines)
+
+
+def members(results, prefix):
+    """Имена prefix/<параметр> в порядке запуска и их параметры."""
+    pattern = re.compile(re.escape(prefix) + r"/(.+)$")
+    return [(name, pattern.match(name).group(1)) for name in results.order if pattern.match(name)]
+
+
+# ==== Таблицы ====
+
+def table_environment(results):
+    context = results.context
+    if not context:
+        return None
+    caches = ", ".join("L%d %s %s" % (c["level"], c["type"], fmt_bytes(c["size"]))
+                       for c in context.get("caches", []))
+    lines = [
+        "- CPU: %d x %d MHz (%s)" % (context.get("num_cpus", 0), context.get("mhz_per_cpu", 0), caches),
+        "- Compiler: GCC %s, -O3" % context.get("compiler", "?"),
+        "- Transform kernel: %s" % context.get("transform_kernel", "?"),
+        "- Run: %s, %s" % (context.get("date", "?"), context.get("executable", "?")),
+    ]
+    return "\n".join(lines)
+
+
+def table_string_length(results):
+    rows = []
+    for name, length in members(results, "BM_CString"):
+        std_name = "BM_StdString/" + length
+        rows.append(["%s bytes" % length,
+                     fmt_time(results.median(name)), fmt_count(results.median(name, "items_per_second")),
+                     fmt_time(results.median(std_name)), fmt_count(results.median(std_name, "items_per_second"))])
+    return table(["String Length", "const char*", "Operations/sec", "std::string", "Operations/sec"], rows) if rows else None
+
+
+def table_literal(results):
+    rows = []
+    for name, length in members(results, "BM_Literal"):
+        literal = results.median(name)
+        runtime = results.median("BM_CString/" + length)
+        speedup = "%.1fx" % (runtime / literal) if literal and runtime else "-"
+        rows.append(["%s bytes" % length, fmt_time(literal), fmt_time(runtime), speedup])
+    return table(["String Length", "Literal path", "Runtime path", "Speedup"], rows) if rows else None
+
+
+def table_numbers(results, prefix):
+    rows = []
+    for name, type_name in members(results, prefix):
+        rows.append([type_name, fmt_count(results.median(name, "items_per_second")), fmt_time(results.median(name))])
+    return table(["Data Type", "Operations/sec", "Time per op"], rows) if rows else None
+
+
+def table_cache_size(results):
+    rows = []
+    for name, entries in members(results, "BM_CacheSize"):
+        rows.append(["%s entries" % fmt_count(float(entries)), fmt_percent(results.median(name, "hit_rate")),
+                     fmt_count(results.median(name, "items_per_second")),
+                     fmt_bytes(results.median(name, "memory_bytes"))])
+    return table(["Cache Size", "Hit Rate", "Operations/sec", "Memory Overhead"], rows) if rows else None
+
+
+def table_cache_lookup(results):
+    rows = []
+    for name, entries in members(results, "BM_CacheLookup"):
+        rows.append([fmt_count(float(entries)), fmt_time(results.median(name)),
+                     fmt_count(results.median(name, "items_per_second")),
+                     fmt_bytes(results.median(name, "heap_bytes_per_entry")),
+                     fmt_bytes(results.median(name, "accounted_bytes_per_entry"))])
+    return table(["Entries", "Lookup", "Lookups/sec", "Heap per Entry", "Accounted per Entry"], rows) if rows else None
+
+
+def table_thread_scaling(results):
+    rows = []
+    baseline = None
+    for name, suffix in members(results, "BM_Concurrent/real_time"):
+        threads = suffix.split(":")[-1]
+        ops = results.median(name, "items_per_second")
+        baseline = baseline or ops
+        scaling = "%.2fx" % (ops / baseline) if ops and baseline else "-"
+        rows.append([threads, fmt_count(ops), scaling])
+    return table(["Threads", "Operations/sec", "Scaling Factor"], rows) if rows else None
+
+
+def table_transform_kernels(results):
+    rows = []
+    sizes = {}
+    for name, suffix in members(results, "BM_Transform/char"):
+        kernel, size = suffix.split("/")
+        sizes.setdefault(int(size), []).append(kernel)
+    for size in sorted(sizes):
+        label = "%d KB" % (size >> 10) if size < (1 << 20) else "%d MB" % (size >> 20)
+        for kernel in sizes[size]:
+            suffix = "%s/%d" % (kernel, size)
+            rows.append([label, kernel, fmt_rate(results.median("BM_Transform/char/" + suffix, "bytes_per_second")),
+                         fmt_rate(results.median("BM_Transform/wchar_t/" + suffix, "bytes_per_second"))])
+    return table(["Buffer", "Kernel", "char", "wchar_t"], rows) if rows else None
+
+
+def table_bulk(results):
+    rows = []
+    for name, count in members(results, "BM_BulkRange"):
+        count = count.split("/")[0]
+        bulk = results.median(name, "items_per_second")
+        single = results.median("BM_BulkElementwise/" + count, "items_per_second")
+        speedup = "%.0fx" % (bulk / single) if bulk and single else "-"
+        rows.append([fmt_count(float(count)), fmt_count(single), fmt_count(bulk), speedup])
+    return table(["Elements", "obfuscate() per element/sec", "obfuscateRange elements/sec", "Speedup"], rows) if rows else None
+
+
+def table_bulk_kernels(results):
+    rows = []
+    for name, kernel in members(results, "BM_BulkKernel"):
+        rows.append([kernel, fmt_count(results.median(name, "items_per_second"))])
+    return table(["Kernel", "int32 elements/sec (1M)"], rows) if rows else None
+
+
+TABLES = {
+    "environment": table_environment,
+    "string_length": table_string_length,
+    "literal": table_literal,
+    "integer": lambda results: table_numbers(results, "BM_Integer"),
+    "float": lambda results: table_numbers(results, "BM_Float"),
+    "cache_size": table_cache_size,
+    "cache_lookup": table_cache_lookup,
+    "thread_scaling": table_thread_scaling,
+    "transform_kernels": table_transform_kernels,
+    "bulk": table_bulk,
+    "bulk_kernels": table_bulk_kernels,
+}
+
+MARKER = re.compile(r"(<!-- benchmark:(\w+) -->\n)(.*?)(<!-- /benchmark -->)", re.S)
+
+
+def command_tables(args):
+    results = load(args.results)
+    rendered = {name: build(results) for name, build in TABLES.items()}
+    if not args.update:
+        for name, text in rendered.items():
+            if text:
+                print("<!-- benchmark:%s -->\n%s\n<!-- /benchmark -->\n" % (name, text))
+        return 0
+
+    with open(args.update) as stream:
+        document = stream.read()
+
+    def replace(match):
+        text = rendered.get(match.group(2))
+        if text is None:
+            print("bench_report: no results for table '%s', left unchanged" % match.group(2), file=sys.stderr)
+            return match.group(0)
+        return match.group(1) + text + "\n" + match.group(4)
+
+    with open(args.update, "w") as stream:
+        stream.write(MARKER.sub(replace, document))
+    return 0
+
+
+# ==== Сравнение ====
+
+def mann_whitney_p(a, b):
+    """Двусторонний p по нормальному приближению с поправкой на связки."""
+    ranked = sorted([(value, 0) for value in a] + [(value, 1) for value in b])
+    ranks = [0.0] * len(ranked)
+    ties = 0.0
+    i = 0
+    while i < len(ranked):
+        j = i
+        while j + 1 < len(ranked) and ranked[j + 1][0] == ranked[i][0]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[k] = (i + j) / 2.0 + 1
+        count = j - i + 1
+        ties += count ** 3 - count
+        i = j + 1
+    n1, n2 = len(a), len(b)
+    u = sum(rank for rank, (_, group) in zip(ranks, ranked) if group == 0) - n1 * (n1 + 1) / 2.0
+    n = n1 + n2
+    variance = n1 * n2 / 12.0 * ((n + 1) - ties / (n * (n - 1)))
+    if variance <= 0:
+        return 1.0
+    z = (abs(u - n1 * n2 / 2.0) - 0.5) / math.sqrt(variance)
+    return math.erfc(max(z, 0.0) / math.sqrt(2))
+
+
+def command_compare(args):
+    baseline = load(args.baseline)
+    contender = load(args.contender)
+    threshold = args.threshold / 100.0
+    regressions = 0
+
+    print("%-44s %12s %12s %9s %8s" % ("Benchmark", "Baseline", "Contender", "Change", "p"))
+    for name in baseline.order:
+        if name not in contender.samples:
+            print("%-44s %12s %12s" % (name, fmt_time(baseline.median(name)), "missing"))
+            continue
+        old, new = baseline.times(name), contender.times(name)
+        change = statistics.median(new) / statistics.median(old) - 1.0
+        enough = len(old) >= 3 and len(new) >= 3
+        p = mann_whitney_p(old, new) if enough else None
+        significant = p is None or p < args.alpha
+        verdict = ""
+        if abs(change) > threshold and significant:
+            verdict = "REGRESSION" if change > 0 else "improved"
+            regressions += change > 0
+        line = "%-44s %12s %12s %+8.1f%% %8s  %s" % (name, fmt_time(statistics.median(old)),
+                                                     fmt_time(statistics.median(new)), change * 100,
+                                                     "-" if p is None else "%.3f" % p, verdict)
+        print(line.rstrip())
+    for name in contender.order:
+        if name not in baseline.samples:
+            print("%-44s %12s %12s" % (name, "new", fmt_time(contender.median(name))))
+
+    if regressions:
+        print("\n%d regression(s) above %.1f%%" % (regressions, args.threshold), file=sys.stderr)
+        return 1
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="FeelMeHappy benchmark tables and comparison")
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    tables = commands.add_parser("tables", help="render docs/BENCHMARKS.md tables")
+    tables.add_argument("results")
+    tables.add_argument("--update", metavar="DOC", help="replace the marked tables in DOC")
+    tables.set_defaults(run=command_tables)
+
+    compare = commands.add_parser("compare", help="flag regressions between two result files")
+    compare.add_argument("baseline")
+    compare.add_argument("contender")
+    compare.add_argument("--threshold", type=float, default=5.0, help="slowdown in percent (default 5)")
+    compare.add_argument("--alpha", type=float, default=0.05, help="significance level (default 0.05)")
+    compare.set_defaults(run=command_compare)
+
+    args = parser.parse_args()
+    return args.run(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,448 @@
+/*
+feelme - обфускация файлов, деревьев каталогов и stdin преобразованием строк FeelMeHappy
+
+    feelme [-k KEY] [-j THREADS] [-c CHUNK] [-o OUTPUT] [INPUT...]
+    feelme --bench MB
+
+Без входов или со входом "-" читает stdin и пишет в stdout. Один файл без -o
+пишется в stdout, иначе OUTPUT - файл для одного входа или каталог, в котором
+повторяется структура входных каталогов. Выход, совпадающий со входом,
+преобразуется на месте. Результат совпадает с
+ObfuscationAlgorithms::obfuscateString для всего файла.
+*/
+
+#include "FeelMeHappy.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define FEELME_POSIX
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+using namespace _feel_me_happy_;
+
+namespace {
+
+// Часть файла - единица параллельной работы
+constexpr Size kPartSize = 8u << 20;
+
+struct Options {
+    Byte key = 0;
+    bool keySet = false;
+    Size threads = 0;
+    Size chunk = FEELMEHAPPY_STREAM_CHUNK;
+    std::string output;
+    std::vector<std::string> inputs;
+    Size benchMegabytes = 0;
+    bool quiet = false;
+};
+
+struct Job {
+    fs::path input;
+    fs::path output;
+};
+
+// Входной файл отображается в память, выходной создаётся нужного размера
+// и тоже отображается: преобразование пишет сразу в страницы файла без
+// промежуточных буферов и системных вызовов read/write. Без POSIX файл
+// читается целиком и записывается при закрытии.
+class MappedPair {
+private:
+    Size length = 0;
+    const char* source = nullptr;
+    char* target = nullptr;
+#ifdef FEELME_POSIX
+    int inputFd = -1;
+    int outputFd = -1;
+#else
+    std::vector<char> inputData;
+    std::vector<char> outputData;
+    fs::path outputPath;
+#endif
+
+#ifdef FEELME_POSIX
+    // Вход и выход - один файл: отображение MAP_SHARED на запись без усечения
+    bool openInPlace(const Job& job, std::string& error) {
+        ::close(inputFd);
+        inputFd = -1;
+        outputFd = ::open(job.output.c_str(), O_RDWR);
+        if (outputFd < 0) {
+            error = job.output.string() + ": " + std::strerror(errno);
+            length = 0;
+            return false;
+        }
+        if (length == 0) return true;
+        
+        void* data = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, outputFd, 0);
+        if (data == MAP_FAILED) {
+            error = job.output.string() + ": mmap: " + std::strerror(errno);
+            length = 0;
+            return false;
+        }
+        madvise(data, length, MADV_SEQUENTIAL);
+        source = target = static_cast<char*>(data);
+        return true;
+    }
+#endif
+
+public:
+    MappedPair() = default;
+    MappedPair(const MappedPair&) = delete;
+    MappedPair& operator=(const MappedPair&) = delete;
+    
+    ~MappedPair() {
+        close();
+    }
+    
+    bool open(const Job& job, std::string& error) {
+#ifdef FEELME_POSIX
+        inputFd = ::open(job.input.c_str(), O_RDONLY);
+        if (inputFd < 0) {
+            error = job.input.string() + ": " + std::strerror(errno);
+            return false;
+        }
+        struct stat info;
+        if (fstat(inputFd, &info) != 0) {
+            error = job.input.string() + ": " + std::strerror(errno);
+            return false;
+        }
+        length = static_cast<Size>(info.st_size);
+        
+        // Выход совпадает со входом (-o на тот же файл или каталог вывода
+        // поверх входного дерева): O_TRUNC уничтожил бы вход до отображения,
+        // поэтому файл отображается один раз и преобразуется на месте
+        struct stat existing;
+        if (stat(job.output.c_str(), &existing) == 0 &&
+            existing.st_dev == info.st_dev && existing.st_ino == info.st_ino) {
+            return openInPlace(job, error);
+        }
+        
+        outputFd = ::open(job.output.c_str(), O_RDWR | O_CREAT | O_TRUNC, info.st_mode & 0777);
+        if (outputFd < 0 || ftruncate(outputFd, static_cast<off_t>(length)) != 0) {
+            error = job.output.string() + ": " + std::strerror(errno);
+            return false;
+        }
+        if (length == 0) return true;
+        
+        void* in = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, inputFd, 0);
+        void* out = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, outputFd, 0);
+        if (in == MAP_FAILED || out == MAP_FAILED) {
+            error = job.input.string() + ": mmap: " + std::strerror(errno);
+            if (in != MAP_FAILED) munmap(in, length);
+            if (out != MAP_FAILED) munmap(out, length);
+            length = 0;
+            return false;
+        }
+        madvise(in, length, MADV_SEQUENTIAL);
+        source = static_cast<const char*>(in);
+        target = static_cast<char*>(out);
+        return true;
+#else
+        std::ifstream in(job.input, std::ios::binary);
+        if (!in) {
+            error = job.input.string() + ": cannot open";
+            return false;
+        }
+        inputData.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        length = inputData.size();
+        outputData.resize(length);
+        outputPath = job.output;
+        source = inputData.data();
+        target = outputData.data();
+        return true;
+#endif
+    }
+    
+    void close() {
+#ifdef FEELME_POSIX
+        if (length != 0 && source) {
+            if (source != target) {
+                munmap(const_cast<char*>(source), length);
+            }
+            munmap(target, length);
+        }
+        if (inputFd >= 0) ::close(inputFd);
+        if (outputFd >= 0) ::close(outputFd);
+        inputFd = outputFd = -1;
+#else
+        if (!outputPath.empty()) {
+            std::ofstream out(outputPath, std::ios::binary);
+            out.write(outputData.data(), static_cast<std::streamsize>(outputData.size()));
+            outputPath.clear();
+        }
+#endif
+        source = nullptr;
+        target = nullptr;
+        length = 0;
+    }
+    
+    Size size() const { return length; }
+    const char* input() const { return source; }
+    char* output() const { return target; }
+};
+
+void usage() {
+    std::cerr << "usage: feelme [-k KEY] [-j THREADS] [-c CHUNK] [-o OUTPUT] [-q] [INPUT...]\n"
+                 "       feelme --bench MB\n"
+                 "  -k KEY      key byte, decimal or 0x-hex (default: random, printed to stderr)\n"
+                 "  -j THREADS  parallel workers (default: all cores)\n"
+                 "  -c CHUNK    stdin/stdout chunk in bytes (default: 1 MB)\n"
+                 "  -o OUTPUT   output file for one input, otherwise output directory\n"
+                 "  -q          no throughput report\n"
+                 "  --bench MB  obfuscate a generated corpus of MB megabytes and report throughput\n";
+}
+
+bool parseSize(const char* text, Size& value) {
+    char* end = nullptr;
+    unsigned long long parsed = std::strtoull(text, &end, 0);
+    if (!end || *end != '\0' || end == text) return false;
+    value = static_cast<Size>(parsed);
+    return true;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&](Size& value) {
+            return i + 1 < argc && parseSize(argv[++i], value);
+        };
+        Size value = 0;
+        if (arg == "-k" || arg == "--key") {
+            if (!next(value) || value > 0xFF) return false;
+            options.key = static_cast<Byte>(value);
+            options.keySet = true;
+        } else if (arg == "-j" || arg == "--jobs") {
+            if (!next(options.threads)) return false;
+        } else if (arg == "-c" || arg == "--chunk") {
+            if (!next(options.chunk) || options.chunk == 0) return false;
+        } else if (arg == "-o" || arg == "--output") {
+            if (i + 1 >= argc) return false;
+            options.output = argv[++i];
+        } else if (arg == "--bench") {
+            if (!next(options.benchMegabytes) || options.benchMegabytes == 0) return false;
+        } else if (arg == "-q" || arg == "--quiet") {
+            options.quiet = true;
+        } else if (arg == "-h" || arg == "--help" || (arg.size() > 1 && arg[0] == '-')) {
+            return false;
+        } else {
+            options.inputs.push_back(arg);
+        }
+    }
+    return true;
+}
+
+// stdin -> stdout кусками: память ограничена одним куском, сам кусок
+// обрабатывается пулом, если он больше двух частей
+Size obfuscateStdio(const Options& options, WorkerPool& pool) {
+    StreamObfuscator stream(options.key, std::max<Size>(options.chunk / pool.concurrency(), 4096), &pool);
+    std::vector<char> buffer(options.chunk);
+    Size total = 0;
+    while (true) {
+        Size filled = std::fread(buffer.data(), 1, buffer.size(), stdin);
+        if (filled == 0) break;
+        stream.update(buffer.data(), filled);
+        if (std::fwrite(buffer.data(), 1, filled, stdout) != filled) {
+            std::cerr << "feelme: write error" << std::endl;
+            break;
+        }
+        total += filled;
+    }
+    std::fflush(stdout);
+    return total;
+}
+
+// Входы раскрываются в список файлов; для каталогов структура
+// повторяется в каталоге вывода
+bool collectJobs(const Options& options, std::vector<Job>& jobs) {
+    bool single = options.inputs.size() == 1 && fs::is_regular_file(options.inputs[0]);
+    for (const auto& input : options.inputs) {
+        fs::path root(input);
+        std::error_code error;
+        if (fs::is_directory(root, error)) {
+            for (auto it = fs::recursive_directory_iterator(root, error); !error && it != fs::recursive_directory_iterator(); it.increment(error)) {
+                if (!it->is_regular_file()) continue;
+                fs::path target = fs::path(options.output) / root.filename() / fs::relative(it->path(), root);
+                fs::create_directories(target.parent_path());
+                jobs.push_back({it->path(), target});
+            }
+        } else if (fs::is_regular_file(root, error)) {
+            fs::path target = single ? fs::path(options.output) : fs::path(options.output) / root.filename();
+            if (!single) fs::create_directories(options.output);
+            jobs.push_back({root, target});
+        } else {
+            std::cerr << "feelme: " << input << ": no such file or directory" << std::endl;
+            return false;
+        }
+        if (error) {
+            std::cerr << "feelme: " << input << ": " << error.message() << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Файлы открываются параллельно, затем все части всех файлов - крупные
+// первыми - раздаются пулу через общий счётчик: освободившийся поток
+// берёт следующую часть, так что один большой файл не держит остальных
+Size obfuscateFiles(const std::vector<Job>& jobs, Byte key, WorkerPool& pool, bool& failed) {
+    std::vector<MappedPair> files(jobs.size());
+    std::vector<std::string> errors(jobs.size());
+    pool.parallelFor(jobs.size(), [&](Size i) {
+        files[i].open(jobs[i], errors[i]);
+    });
+    
+    struct Part {
+        Size file;
+        Size offset;
+        Size length;
+    };
+    std::vector<Part> parts;
+    Size total = 0;
+    for (Size i = 0; i < files.size(); ++i) {
+        if (!errors[i].empty()) {
+            std::cerr << "feelme: " << errors[i] << std::endl;
+            failed = true;
+            continue;
+        }
+        for (Size offset = 0; offset < files[i].size(); offset += kPartSize) {
+            parts.push_back({i, offset, std::min(kPartSize, files[i].size() - offset)});
+        }
+        total += files[i].size();
+    }
+    std::stable_sort(parts.begin(), parts.end(), [](const Part& a, const Part& b) { return a.length > b.length; });
+    
+    pool.parallelFor(parts.size(), [&](Size index) {
+        const Part& part = parts[index];
+        const MappedPair& file = files[part.file];
+        StreamObfuscator stream(key, kPartSize, nullptr);
+        stream.seek(part.offset);
+        stream.update(file.input() + part.offset, part.length, file.output() + part.offset);
+    });
+    
+    pool.parallelFor(files.size(), [&](Size i) {
+        files[i].close();
+    });
+    return total;
+}
+
+void report(const char* what, Size bytes, Size files, double seconds, Size threads) {
+    double megabytes = bytes / 1024.0 / 1024.0;
+    std::fprintf(stderr, "feelme: %s %.1f MB in %.3f s, %.1f MB/s (%zu files, %zu threads)\n",
+                 what, megabytes, seconds, seconds > 0 ? megabytes / seconds : 0.0,
+                 static_cast<size_t>(files), static_cast<size_t>(threads));
+}
+
+// Сквозной замер: корпус из файлов по 16 MB и мелких файлов во временном
+// каталоге. Первый проход создаёт выходные файлы, второй перезаписывает их.
+int runBenchmark(const Options& options, WorkerPool& pool) {
+    fs::path root = fs::temp_directory_path() / ("feelme-bench-" + std::to_string(std::random_device{}()));
+    fs::path corpus = root / "corpus";
+    fs::create_directories(corpus);
+    
+    const Size total = options.benchMegabytes << 20;
+    const Size largeFile = 16u << 20;
+    std::vector<Size> sizes;
+    for (Size left = total; left > 0;) {
+        // Каждый восьмой файл мелкий, как конфиги рядом с ресурсами
+        Size size = sizes.size() % 8 == 7 ? std::min<Size>(left, 64u << 10) : std::min(left, largeFile);
+        sizes.push_back(size);
+        left -= size;
+    }
+    pool.parallelFor(sizes.size(), [&](Size i) {
+        std::vector<char> data(sizes[i]);
+        std::mt19937_64 rng(i);
+        for (Size j = 0; j + 8 <= data.size(); j += 8) {
+            QWord value = rng();
+            std::memcpy(&data[j], &value, 8);
+        }
+        std::ofstream out(corpus / ("asset_" + std::to_string(i) + ".bin"), std::ios::binary);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    });
+    
+    Options run = options;
+    run.inputs = {corpus.string()};
+    run.output = (root / "out").string();
+    std::vector<Job> jobs;
+    if (!collectJobs(run, jobs)) return 1;
+    
+    bool failed = false;
+    for (int pass = 0; pass < 2; ++pass) {
+        auto start = std::chrono::steady_clock::now();
+        Size bytes = obfuscateFiles(jobs, options.key, pool, failed);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        report(pass == 0 ? "bench, new outputs:" : "bench, overwrite:", bytes, jobs.size(), seconds, pool.concurrency());
+    }
+    
+    std::error_code error;
+    fs::remove_all(root, error);
+    return failed ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+    if (!options.keySet) {
+        options.key = KeyGenerator::generateByte();
+        if (options.benchMegabytes == 0) {
+            std::fprintf(stderr, "feelme: key 0x%02X\n", options.key);
+        }
+    }
+    
+    Size threads = options.threads ? options.threads : std::max<Size>(std::thread::hardware_concurrency(), 1);
+    WorkerPool pool(threads - 1);
+    
+    if (options.benchMegabytes != 0) {
+        return runBenchmark(options, pool);
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    bool stdio = options.inputs.empty() || (options.inputs.size() == 1 && options.inputs[0] == "-");
+    bool toStdout = options.output.empty() && options.inputs.size() == 1 && fs::is_regular_file(options.inputs[0]);
+    Size bytes = 0;
+    Size files = 0;
+    bool failed = false;
+    
+    if (stdio) {
+        bytes = obfuscateStdio(options, pool);
+    } else if (toStdout) {
+        // Один файл в stdout: чтение кусками, как для stdin
+        if (!std::freopen(options.inputs[0].c_str(), "rb", stdin)) {
+            std::cerr << "feelme: " << options.inputs[0] << ": " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        bytes = obfuscateStdio(options, pool);
+        files = 1;
+    } else {
+        if (options.output.empty()) {
+            std::cerr << "feelme: -o is required for several inputs or directories" << std::endl;
+            return 2;
+        }
+        std::vector<Job> jobs;
+        if (!collectJobs(options, jobs)) return 1;
+        bytes = obfuscateFiles(jobs, options.key, pool, failed);
+        files = jobs.size();
+    }
+    
+    if (!options.quiet) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        report("obfuscated", bytes, files, seconds, pool.concurrency());
+    }
+    return failed ? 1 : 0;
+}